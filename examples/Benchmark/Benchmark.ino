@@ -0,0 +1,178 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "mpu9250.h"
+
+/* Mpu9250 objects on SPI bus 0, chip select 10, and I2C bus 0, address 0x68 */
+Mpu9250 spi_imu(&SPI, 10);
+Mpu9250 i2c_imu(&Wire, 0x68);
+/* Number of timed iterations for each operation */
+const uint16_t NUM_ITER = 100;
+/* Buffer large enough to hold a full FIFO */
+uint8_t fifo_buff[512];
+
+/* Min, mean, and max timing in us */
+struct Timing {
+  uint32_t min_us;
+  uint32_t max_us;
+  uint32_t total_us;
+  uint32_t count;
+};
+
+void Reset(Timing *t) {
+  t->min_us = 0xFFFFFFFF;
+  t->max_us = 0;
+  t->total_us = 0;
+  t->count = 0;
+}
+
+void Add(Timing *t, const uint32_t dt_us) {
+  if (dt_us < t->min_us) {t->min_us = dt_us;}
+  if (dt_us > t->max_us) {t->max_us = dt_us;}
+  t->total_us += dt_us;
+  t->count++;
+}
+
+void Print(const char *name, const Timing &t) {
+  Serial.print(name);
+  Serial.print("\t");
+  if (!t.count) {
+    Serial.println("failed");
+    return;
+  }
+  Serial.print(t.min_us);
+  Serial.print("\t");
+  Serial.print(static_cast<float>(t.total_us) / t.count, 1);
+  Serial.print("\t");
+  Serial.println(t.max_us);
+}
+
+void Benchmark(Mpu9250 *imu, const char *name) {
+  Timing t;
+  uint32_t t0;
+  bool status;
+  Serial.print("\n");
+  Serial.println(name);
+  Serial.println("Operation\tMin us\tMean us\tMax us");
+  /* Begin */
+  Reset(&t);
+  t0 = micros();
+  status = imu->Begin();
+  if (status) {Add(&t, micros() - t0);}
+  Print("Begin", t);
+  if (!status) {
+    return;
+  }
+  /* Configuration */
+  Reset(&t);
+  for (uint16_t i = 0; i < NUM_ITER / 10; i++) {
+    t0 = micros();
+    status = imu->ConfigAccelRange(Mpu9250::ACCEL_RANGE_16G);
+    if (status) {Add(&t, micros() - t0);}
+  }
+  Print("ConfigAccelRange", t);
+  Reset(&t);
+  for (uint16_t i = 0; i < NUM_ITER / 10; i++) {
+    t0 = micros();
+    status = imu->ConfigGyroRange(Mpu9250::GYRO_RANGE_2000DPS);
+    if (status) {Add(&t, micros() - t0);}
+  }
+  Print("ConfigGyroRange", t);
+  Reset(&t);
+  for (uint16_t i = 0; i < NUM_ITER / 10; i++) {
+    t0 = micros();
+    status = imu->ConfigDlpf(Mpu9250::DLPF_BANDWIDTH_184HZ);
+    if (status) {Add(&t, micros() - t0);}
+  }
+  Print("ConfigDlpf", t);
+  Reset(&t);
+  for (uint16_t i = 0; i < NUM_ITER / 10; i++) {
+    t0 = micros();
+    status = imu->ConfigSrd(0);
+    if (status) {Add(&t, micros() - t0);}
+  }
+  Print("ConfigSrd", t);
+  /* Bus time for a data read, whether or not new data was available */
+  Reset(&t);
+  for (uint16_t i = 0; i < NUM_ITER; i++) {
+    t0 = micros();
+    imu->ReadRaw();
+    Add(&t, micros() - t0);
+  }
+  Print("ReadRaw", t);
+  /* Conversion to engineering units */
+  Reset(&t);
+  for (uint16_t i = 0; i < NUM_ITER; i++) {
+    t0 = micros();
+    imu->Convert();
+    Add(&t, micros() - t0);
+  }
+  Print("Convert", t);
+  /* Achieved sample rate polling Read for one second */
+  uint32_t num_samples = 0;
+  t0 = micros();
+  while (micros() - t0 < 1000000) {
+    if (imu->Read()) {
+      num_samples++;
+    }
+  }
+  Serial.print("Read rate\t");
+  Serial.print(num_samples);
+  Serial.println(" Hz");
+  /* FIFO drain throughput, 20 ms of 1000 Hz accel, gyro, and temperature */
+  if (imu->EnableFifo(true, true, false, true)) {
+    Reset(&t);
+    uint32_t num_bytes = 0;
+    for (uint16_t i = 0; i < NUM_ITER / 10; i++) {
+      imu->ResetFifo();
+      delay(20);
+      t0 = micros();
+      status = imu->ReadFifo(fifo_buff, sizeof(fifo_buff));
+      if (status) {
+        Add(&t, micros() - t0);
+        num_bytes += imu->fifo_num_frames() * imu->fifo_frame_size();
+      }
+    }
+    Print("ReadFifo", t);
+    if (t.total_us) {
+      Serial.print("FIFO rate\t");
+      Serial.print(static_cast<float>(num_bytes) * 1000.0f / t.total_us, 1);
+      Serial.println(" kB/s");
+    }
+    imu->DisableFifo();
+  } else {
+    Serial.println("FIFO configuration unsuccessful");
+  }
+}
+
+void setup() {
+  /* Serial to display results */
+  Serial.begin(115200);
+  while(!Serial) {}
+  Benchmark(&spi_imu, "SPI");
+  Benchmark(&i2c_imu, "I2C");
+}
+
+void loop() {}
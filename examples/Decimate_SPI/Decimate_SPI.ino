@@ -0,0 +1,85 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "mpu9250.h"
+#include "mpu9250_decimator.h"
+#include "mpu9250_ring.h"
+
+/* An Mpu9250 object on SPI bus 0 with chip select 10 */
+Mpu9250 imu(&SPI, 10);
+/* Decimated samples are pushed to the ring as they are produced */
+Mpu9250RingBuffer<16> ring;
+Mpu9250Decimator decimator;
+/* Buffer large enough to hold a full FIFO */
+uint8_t fifo_buff[512];
+Mpu9250::Sample sample;
+
+void setup() {
+  /* Serial to display data */
+  Serial.begin(115200);
+  while(!Serial) {}
+  /* Start communication */
+  if (!imu.Begin()) {
+    Serial.println("IMU initialization unsuccessful");
+    while(1) {}
+  }
+  /* Sample the gyro at 8 kHz and widen the accel bandwidth */
+  if (!imu.ConfigGyroBandwidth(Mpu9250::GYRO_BANDWIDTH_250HZ)) {
+    Serial.println("Gyro bandwidth configuration unsuccessful");
+    while(1) {}
+  }
+  if (!imu.ConfigAccelBandwidth(Mpu9250::ACCEL_BANDWIDTH_420HZ)) {
+    Serial.println("Accel bandwidth configuration unsuccessful");
+    while(1) {}
+  }
+  /* Decimate by 32 to 250 Hz */
+  decimator.Config(32);
+  imu.AttachRing(&ring);
+  if (!imu.EnableFifo(true, true, false, false)) {
+    Serial.println("FIFO configuration unsuccessful");
+    while(1) {}
+  }
+}
+
+void loop() {
+  /* The FIFO fills in under 5 ms at 8 kHz, so drain it every loop */
+  if (imu.ReadFifo(fifo_buff, sizeof(fifo_buff))) {
+    decimator.Process(&imu, fifo_buff);
+  }
+  if (imu.fifo_overflow()) {
+    decimator.Reset();
+    Serial.println("FIFO overflow");
+  }
+  while (ring.Pop(&sample)) {
+    /* Display the data */
+    Serial.print(sample.time_us);
+    Serial.print("\t");
+    Serial.print(sample.gyro_radps[0], 6);
+    Serial.print("\t");
+    Serial.print(sample.gyro_radps[1], 6);
+    Serial.print("\t");
+    Serial.println(sample.gyro_radps[2], 6);
+  }
+}
@@ -0,0 +1,74 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "mpu9250.h"
+
+/* An Mpu9250 object on SPI bus 0 with chip select 10 */
+Mpu9250 imu(&SPI, 10);
+/* Buffer large enough to hold a full FIFO */
+uint8_t fifo_buff[512];
+
+void setup() {
+  /* Serial to display data */
+  Serial.begin(115200);
+  while(!Serial) {}
+  /* Start communication */
+  if (!imu.Begin()) {
+    Serial.println("IMU initialization unsuccessful");
+    while(1) {}
+  }
+  /* Buffer accel, gyro, and temperature data at 1000 Hz */
+  if (!imu.EnableFifo(true, true, false, true)) {
+    Serial.println("FIFO configuration unsuccessful");
+    while(1) {}
+  }
+}
+
+void loop() {
+  /* Drain all of the frames collected since the last loop */
+  if (imu.ReadFifo(fifo_buff, sizeof(fifo_buff))) {
+    for (size_t i = 0; i < imu.fifo_num_frames(); i++) {
+      imu.UnpackFifo(fifo_buff, i);
+      /* Display the data */
+      Serial.print(imu.accel_x_mps2(), 6);
+      Serial.print("\t");
+      Serial.print(imu.accel_y_mps2(), 6);
+      Serial.print("\t");
+      Serial.print(imu.accel_z_mps2(), 6);
+      Serial.print("\t");
+      Serial.print(imu.gyro_x_radps(), 6);
+      Serial.print("\t");
+      Serial.print(imu.gyro_y_radps(), 6);
+      Serial.print("\t");
+      Serial.print(imu.gyro_z_radps(), 6);
+      Serial.print("\t");
+      Serial.println(imu.die_temperature_c(), 6);
+    }
+  }
+  if (imu.fifo_overflow()) {
+    Serial.println("FIFO overflow");
+  }
+  delay(10);
+}
@@ -0,0 +1,66 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "mpu9250.h"
+#include "mpu9250_log.h"
+
+/* An Mpu9250 object on SPI bus 0 with chip select 10 */
+Mpu9250 imu(&SPI, 10);
+/* Buffer large enough to hold a full FIFO */
+uint8_t fifo_buff[512];
+/* Buffer of binary records to write in a single block */
+uint8_t log_buff[36 * Mpu9250Log::RECORD_SIZE];
+/* Config record with the magnetometer scale factors */
+uint8_t config_buff[Mpu9250Log::CONFIG_RECORD_SIZE];
+
+void setup() {
+  /* Serial to log data */
+  Serial.begin(115200);
+  while(!Serial) {}
+  /* Start communication */
+  if (!imu.Begin()) {
+    while(1) {}
+  }
+  /* Buffer accel, gyro, and temperature data at 1000 Hz */
+  if (!imu.EnableFifo(true, true, false, true)) {
+    while(1) {}
+  }
+  /* Start the log with the config record, records use config id 0 */
+  Serial.write(config_buff, Mpu9250Log::EncodeConfig(imu, 0, config_buff,
+                                                     sizeof(config_buff)));
+}
+
+void loop() {
+  /* Encode the raw counts of each frame, skipping the conversion */
+  if (imu.ReadFifo(fifo_buff, sizeof(fifo_buff))) {
+    size_t len = 0;
+    for (size_t i = 0; i < imu.fifo_num_frames(); i++) {
+      imu.UnpackFifoRaw(fifo_buff, i);
+      len += Mpu9250Log::Encode(imu, log_buff + len, sizeof(log_buff) - len);
+    }
+    Serial.write(log_buff, len);
+  }
+  delay(10);
+}
@@ -0,0 +1,53 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef EXTRAS_HOST_SPI_H_
+#define EXTRAS_HOST_SPI_H_
+
+#include "Arduino.h"
+
+#define SPI_MODE3 0x0C
+
+/* Host stub, SPI sensors are simulated with an Mpu9250Bus instead */
+class SPISettings {
+ public:
+  SPISettings() {}
+  SPISettings(uint32_t clock, uint8_t order, uint8_t mode) {
+    (void) clock; (void) order; (void) mode;
+  }
+};
+
+class SPIClass {
+ public:
+  void begin() {}
+  void beginTransaction(SPISettings settings) {(void) settings;}
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data) {(void) data; return 0;}
+  void transfer(void *buf, size_t count) {memset(buf, 0, count);}
+};
+
+extern SPIClass SPI;
+
+#endif  // EXTRAS_HOST_SPI_H_
@@ -0,0 +1,49 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef EXTRAS_HOST_WIRE_H_
+#define EXTRAS_HOST_WIRE_H_
+
+#include "Arduino.h"
+
+/* Host stub, I2C sensors are simulated with an Mpu9250Bus instead */
+class TwoWire {
+ public:
+  void begin() {}
+  void end() {}
+  void setClock(uint32_t clock) {(void) clock;}
+  void beginTransmission(uint8_t addr) {(void) addr;}
+  size_t write(uint8_t data) {(void) data; return 1;}
+  size_t write(const uint8_t *data, size_t len) {(void) data; return len;}
+  uint8_t endTransmission(bool stop = true) {(void) stop; return 2;}
+  uint8_t requestFrom(uint8_t addr, uint8_t len) {
+    (void) addr; (void) len; return 0;
+  }
+  int read() {return -1;}
+};
+
+extern TwoWire Wire;
+
+#endif  // EXTRAS_HOST_WIRE_H_
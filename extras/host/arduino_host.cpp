@@ -0,0 +1,63 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "SPI.h"
+
+TwoWire Wire;
+SPIClass SPI;
+
+namespace {
+uint64_t host_time_ns = 0;
+}  // namespace
+
+void pinMode(uint8_t pin, uint8_t mode) {(void) pin; (void) mode;}
+void digitalWrite(uint8_t pin, uint8_t val) {(void) pin; (void) val;}
+int digitalRead(uint8_t pin) {(void) pin; return HIGH;}
+void delay(unsigned long ms) {
+  host_time_ns += static_cast<uint64_t>(ms) * 1000000;
+}
+void delayMicroseconds(unsigned int us) {
+  host_time_ns += static_cast<uint64_t>(us) * 1000;
+}
+unsigned long micros() {
+  return static_cast<unsigned long>(host_time_ns / 1000);
+}
+unsigned long millis() {
+  return static_cast<unsigned long>(host_time_ns / 1000000);
+}
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  (void) pin; (void) isr; (void) mode;
+}
+void detachInterrupt(uint8_t pin) {(void) pin;}
+void noInterrupts() {}
+void interrupts() {}
+uint64_t HostTimeNs() {
+  return host_time_ns;
+}
+void HostAdvanceNs(const uint64_t ns) {
+  host_time_ns += ns;
+}
@@ -0,0 +1,204 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Runs the driver against the simulated sensor on a host computer, reporting
+* the bus transactions and time used by configuration and the decode
+* throughput. Configuration exceeding the expected limits returns 1, so it
+* can be run as a regression check. It is built from the repository root
+* with:
+*
+* g++ -std=gnu++11 -O2 -Iextras/host -Isrc src/mpu9250.cpp \
+*   src/mpu9250_group.cpp src/mpu9250_ring.cpp src/mpu9250_decimator.cpp \
+*   extras/host/arduino_host.cpp extras/host/mpu9250_sim.cpp \
+*   extras/host/host_benchmark.cpp \
+*   -o host_benchmark
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "Arduino.h"
+#include "mpu9250.h"
+#include "mpu9250_decimator.h"
+#include "mpu9250_sim.h"
+
+namespace {
+
+void PrintBus(const char *name, const Mpu9250Sim &sim, const bool status) {
+  printf("%-24s %-6s %8u transactions %8u bytes %10.1f us\n", name,
+         status ? "ok" : "failed", sim.transactions(), sim.bytes(),
+         static_cast<double>(sim.bus_time_ns()) / 1000.0);
+}
+
+/*
+* Expected upper limits on the configuration cost, a regression in the
+* number of transactions or the simulated time, including the I2C master
+* waits, fails the benchmark
+*/
+struct Limit {
+  const char *name;
+  uint32_t max_transactions;
+  double max_ms;
+};
+const Limit LIMITS[] = {
+  {"Begin", 3000, 15.0},
+  {"ConfigSrd", 6000, 6.0},
+  {"ConfigImu", 4, 0.1},
+  {"ConfigDlpf", 6, 0.1},
+  {"SelfTest", 30000, 200.0}
+};
+
+/* Prints the cost of a configuration method and checks it against LIMITS */
+bool CheckConfig(const char *name, const Mpu9250Sim &sim, const bool status,
+                 const uint64_t t0_ns) {
+  PrintBus(name, sim, status);
+  double ms = static_cast<double>(HostTimeNs() - t0_ns) / 1e6;
+  printf("%-24s %.2f ms\n", name, ms);
+  if (!status) {
+    return false;
+  }
+  for (size_t i = 0; i < sizeof(LIMITS) / sizeof(LIMITS[0]); i++) {
+    if (strcmp(LIMITS[i].name, name)) {
+      continue;
+    }
+    if ((sim.transactions() > LIMITS[i].max_transactions) ||
+        (ms > LIMITS[i].max_ms)) {
+      printf("%-24s exceeds %u transactions or %.2f ms\n", name,
+             LIMITS[i].max_transactions, LIMITS[i].max_ms);
+      return false;
+    }
+  }
+  return true;
+}
+
+double ElapsedS(const std::chrono::steady_clock::time_point &t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       t0).count();
+}
+
+}  // namespace
+
+int main() {
+  const uint32_t NUM_SAMPLES = 1000000;
+  /* Replay a short recorded stream */
+  Mpu9250Sim::Record records[64];
+  for (int i = 0; i < 64; i++) {
+    records[i] = {{static_cast<int16_t>(i), static_cast<int16_t>(-i), 2048},
+                  static_cast<int16_t>(100 + i),
+                  {static_cast<int16_t>(3 * i), 0, static_cast<int16_t>(-i)},
+                  {static_cast<int16_t>(200 + i), -50, 400}};
+  }
+  /* 20 MHz SPI */
+  Mpu9250Sim sim(20000000, 8);
+  sim.Replay(records, 64);
+  Mpu9250 imu(&sim);
+  /* Transaction counts and simulated time of configuration */
+  bool pass = true;
+  uint64_t t_ns = HostTimeNs();
+  bool status = imu.Begin();
+  pass = CheckConfig("Begin", sim, status, t_ns) && pass;
+  sim.ResetCounters();
+  t_ns = HostTimeNs();
+  status = imu.ConfigSrd(4);
+  pass = CheckConfig("ConfigSrd", sim, status, t_ns) && pass;
+  sim.ResetCounters();
+  t_ns = HostTimeNs();
+  status = imu.ConfigImu(Mpu9250::ACCEL_RANGE_8G, Mpu9250::GYRO_RANGE_500DPS,
+                         Mpu9250::DLPF_BANDWIDTH_41HZ, 0);
+  pass = CheckConfig("ConfigImu", sim, status, t_ns) && pass;
+  sim.ResetCounters();
+  t_ns = HostTimeNs();
+  status = imu.ConfigDlpf(Mpu9250::DLPF_BANDWIDTH_20HZ);
+  pass = CheckConfig("ConfigDlpf", sim, status, t_ns) && pass;
+  sim.ResetCounters();
+  Mpu9250::SelfTestResult self_test;
+  t_ns = HostTimeNs();
+  status = imu.SelfTest(&self_test);
+  pass = CheckConfig("SelfTest", sim, status, t_ns) && pass;
+  /* Read and decode throughput, one sample per simulated ms */
+  sim.ResetCounters();
+  uint32_t num_read = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+    HostAdvanceNs(1000000);
+    if (imu.Read()) {
+      num_read++;
+    }
+  }
+  double dt = ElapsedS(t0);
+  PrintBus("Read", sim, num_read == NUM_SAMPLES);
+  printf("Read: %u samples, %.2f M samples/s\n", num_read,
+         num_read / dt / 1e6);
+  /* Conversion only */
+  float sum = 0;
+  t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+    imu.Convert();
+    sum += imu.accel_x_mps2();
+  }
+  dt = ElapsedS(t0);
+  printf("Convert: %.2f M conversions/s (%g)\n", NUM_SAMPLES / dt / 1e6, sum);
+  /* FIFO drain, 20 frames of accel, gyro, and temperature per drain */
+  static uint8_t fifo_buff[512];
+  status = imu.EnableFifo(true, true, false, true);
+  sim.ResetCounters();
+  uint32_t num_frames = 0;
+  t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < NUM_SAMPLES / 20; i++) {
+    HostAdvanceNs(20000000);
+    if (imu.ReadFifo(fifo_buff, sizeof(fifo_buff))) {
+      for (size_t j = 0; j < imu.fifo_num_frames(); j++) {
+        imu.UnpackFifo(fifo_buff, j);
+      }
+      num_frames += imu.fifo_num_frames();
+    }
+  }
+  dt = ElapsedS(t0);
+  PrintBus("ReadFifo", sim, status);
+  printf("ReadFifo: %u frames, %.2f M frames/s\n", num_frames,
+         num_frames / dt / 1e6);
+  /* Decimation by 8 of the drained frames */
+  Mpu9250Decimator decimator;
+  decimator.Config(8);
+  num_frames = 0;
+  uint32_t num_out = 0;
+  t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < NUM_SAMPLES / 20; i++) {
+    HostAdvanceNs(20000000);
+    if (imu.ReadFifo(fifo_buff, sizeof(fifo_buff))) {
+      num_out += decimator.Process(&imu, fifo_buff);
+      num_frames += imu.fifo_num_frames();
+    }
+  }
+  dt = ElapsedS(t0);
+  printf("Decimate: %u frames, %u outputs, %.2f M frames/s (%d)\n",
+         num_frames, num_out, num_frames / dt / 1e6, imu.accel_z_cnts());
+  if (!pass) {
+    printf("FAILED: configuration cost regression\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,338 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "mpu9250_sim.h"
+
+constexpr Mpu9250Sim::Record Mpu9250Sim::DEFAULT_RECORD_;
+constexpr int16_t Mpu9250Sim::ST_MAG_[3];
+
+Mpu9250Sim::Mpu9250Sim(const uint32_t clock_hz, const uint8_t bits_per_byte) :
+  clock_hz_(clock_hz), bits_per_byte_(bits_per_byte) {
+  Reset();
+  ResetAk8963();
+  /* Unity sensitivity adjustment */
+  ak_regs_[AK8963_ASA_] = 128;
+  ak_regs_[AK8963_ASA_ + 1] = 128;
+  ak_regs_[AK8963_ASA_ + 2] = 128;
+}
+void Mpu9250Sim::Replay(const Record * const records, const size_t num) {
+  records_ = records;
+  num_records_ = num;
+  record_ = 0;
+}
+void Mpu9250Sim::Begin() {}
+bool Mpu9250Sim::WriteRegisters(const uint8_t reg, const uint8_t count,
+                                const uint8_t * const data) {
+  CountTransfer(count);
+  Update();
+  for (uint8_t i = 0; i < count; i++) {
+    WriteRegister(static_cast<uint8_t>(reg + i), data[i]);
+  }
+  return true;
+}
+bool Mpu9250Sim::ReadRegisters(const uint8_t reg, const uint8_t count,
+                               uint8_t * const data) {
+  CountTransfer(count);
+  Update();
+  /* The FIFO is read repeatedly, other registers auto increment */
+  for (uint8_t i = 0; i < count; i++) {
+    data[i] = ReadRegister((reg == FIFO_R_W_) ? reg :
+                           static_cast<uint8_t>(reg + i));
+  }
+  /* INT_ANYRD_2CLEAR clears the interrupt status on any read */
+  if (regs_[INT_PIN_CFG_] & 0x10) {
+    regs_[INT_STATUS_] = 0;
+  }
+  return true;
+}
+void Mpu9250Sim::ResetCounters() {
+  transactions_ = 0;
+  bytes_ = 0;
+  bus_time_ns_ = 0;
+  samples_ = 0;
+}
+void Mpu9250Sim::Reset() {
+  memset(regs_, 0, sizeof(regs_));
+  regs_[WHOAMI_] = 0x71;
+  regs_[PWR_MGMNT_1_] = 0x01;
+  memset(regs_ + SELF_TEST_X_GYRO_, ST_CODE_, 3);
+  memset(regs_ + SELF_TEST_X_ACCEL_, ST_CODE_, 3);
+  fifo_count_ = 0;
+  next_sample_ns_ = HostTimeNs() + 1000000;
+  slv4_pending_ = false;
+}
+void Mpu9250Sim::ResetAk8963() {
+  uint8_t asa[3];
+  memcpy(asa, ak_regs_ + AK8963_ASA_, sizeof(asa));
+  memset(ak_regs_, 0, sizeof(ak_regs_));
+  memcpy(ak_regs_ + AK8963_ASA_, asa, sizeof(asa));
+  ak_regs_[0x00] = 0x48;
+}
+uint64_t Mpu9250Sim::SamplePeriodNs() const {
+  /* FCHOICE_B bypass runs at 32 kHz, DLPF_CFG 0 or 7 at 8 kHz */
+  if (regs_[GYRO_CONFIG_] & 0x03) {
+    return 31250;
+  }
+  uint8_t dlpf_cfg = regs_[CONFIG_] & 0x07;
+  if ((dlpf_cfg == 0) || (dlpf_cfg == 7)) {
+    return 125000;
+  }
+  return (static_cast<uint64_t>(regs_[SMPLRT_DIV_]) + 1) * 1000000;
+}
+void Mpu9250Sim::Update() {
+  uint64_t now_ns = HostTimeNs();
+  while (now_ns >= next_sample_ns_) {
+    Sample(next_sample_ns_ / 1000);
+    next_sample_ns_ += SamplePeriodNs();
+  }
+  /* The I2C master only runs SLV4 while it is enabled */
+  if ((slv4_pending_) && (now_ns >= slv4_done_ns_) &&
+      (regs_[USER_CTRL_] & 0x20)) {
+    slv4_pending_ = false;
+    regs_[I2C_SLV4_CTRL_] &= ~0x80;
+    Slv4Transfer();
+  }
+}
+void Mpu9250Sim::Sample(const uint64_t time_us) {
+  const Record &rec = (num_records_) ? records_[record_] : DEFAULT_RECORD_;
+  if (num_records_) {
+    record_ = (record_ + 1) % num_records_;
+  }
+  samples_++;
+  /* Accel, temperature, and gyro data, big endian */
+  for (uint8_t i = 0; i < 3; i++) {
+    /* Self test adds a fixed response on each enabled axis */
+    uint16_t accel = static_cast<uint16_t>(rec.accel[i]);
+    uint16_t gyro = static_cast<uint16_t>(rec.gyro[i]);
+    if (regs_[ACCEL_CONFIG_] & (0x80 >> i)) {
+      accel += ST_RESP_;
+    }
+    if (regs_[GYRO_CONFIG_] & (0x80 >> i)) {
+      gyro += ST_RESP_;
+    }
+    regs_[ACCEL_OUT_ + 2 * i] = accel >> 8;
+    regs_[ACCEL_OUT_ + 2 * i + 1] = accel & 0xFF;
+    regs_[GYRO_OUT_ + 2 * i] = gyro >> 8;
+    regs_[GYRO_OUT_ + 2 * i + 1] = gyro & 0xFF;
+  }
+  regs_[TEMP_OUT_] = static_cast<uint16_t>(rec.temp) >> 8;
+  regs_[TEMP_OUT_ + 1] = rec.temp & 0xFF;
+  regs_[INT_STATUS_] |= 0x01;
+  /* AK8963 continuous measurement at 8 Hz or 100 Hz, little endian */
+  uint8_t mode = ak_regs_[AK8963_CNTL1_] & 0x0F;
+  if ((mode == 0x02) || (mode == 0x06)) {
+    if (time_us >= next_mag_us_) {
+      for (uint8_t i = 0; i < 3; i++) {
+        ak_regs_[AK8963_HXL_ + 2 * i] = rec.mag[i] & 0xFF;
+        ak_regs_[AK8963_HXL_ + 2 * i + 1] =
+          static_cast<uint16_t>(rec.mag[i]) >> 8;
+      }
+      ak_regs_[AK8963_ST1_] |= 0x01;
+      next_mag_us_ = time_us + ((mode == 0x02) ? 125000 : 10000);
+    }
+  }
+  /* SLV0 reads into the external sensor data registers each sample */
+  uint8_t slv0_len = 0;
+  if ((regs_[I2C_SLV0_CTRL_] & 0x80) &&
+      ((regs_[I2C_SLV0_ADDR_] & 0x7F) == AK8963_I2C_ADDR_) &&
+      (regs_[I2C_SLV0_ADDR_] & 0x80)) {
+    slv0_len = regs_[I2C_SLV0_CTRL_] & 0x0F;
+    for (uint8_t i = 0; i < slv0_len; i++) {
+      regs_[EXT_SENS_DATA_00_ + i] =
+        ReadAk8963Register(static_cast<uint8_t>(regs_[I2C_SLV0_REG_] + i));
+    }
+  }
+  /* FIFO frames are in register order, accel, temperature, gyro, SLV0 */
+  if (regs_[USER_CTRL_] & 0x40) {
+    uint8_t fifo_en = regs_[FIFO_EN_];
+    if (fifo_en & 0x08) {
+      FifoPush(regs_ + ACCEL_OUT_, 6);
+    }
+    if (fifo_en & 0x80) {
+      FifoPush(regs_ + TEMP_OUT_, 2);
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+      if (fifo_en & (0x40 >> i)) {
+        FifoPush(regs_ + GYRO_OUT_ + 2 * i, 2);
+      }
+    }
+    if (fifo_en & 0x01) {
+      FifoPush(regs_ + EXT_SENS_DATA_00_, slv0_len);
+    }
+  }
+}
+void Mpu9250Sim::FifoPush(const uint8_t * const data, const size_t len) {
+  /* Full FIFOs drop data, the driver resets the FIFO on overflow */
+  for (size_t i = 0; (i < len) && (fifo_count_ < sizeof(fifo_)); i++) {
+    fifo_[fifo_count_++] = data[i];
+  }
+}
+void Mpu9250Sim::Slv4Transfer() {
+  uint8_t addr = regs_[I2C_SLV4_ADDR_];
+  if ((addr & 0x7F) != AK8963_I2C_ADDR_) {
+    /* Done with a NACK */
+    regs_[I2C_MST_STATUS_] |= 0x50;
+    return;
+  }
+  if (addr & 0x80) {
+    regs_[I2C_SLV4_DI_] = ReadAk8963Register(regs_[I2C_SLV4_REG_]);
+  } else {
+    WriteAk8963Register(regs_[I2C_SLV4_REG_], regs_[I2C_SLV4_DO_]);
+  }
+  regs_[I2C_MST_STATUS_] |= 0x40;
+}
+void Mpu9250Sim::WriteRegister(const uint8_t reg, const uint8_t data) {
+  if (reg >= sizeof(regs_)) {
+    return;
+  }
+  switch (reg) {
+    case PWR_MGMNT_1_: {
+      if (data & 0x80) {
+        Reset();
+      } else {
+        regs_[reg] = data;
+      }
+      break;
+    }
+    case USER_CTRL_: {
+      /* FIFO, I2C master, and signal path resets self clear */
+      if (data & 0x04) {
+        fifo_count_ = 0;
+      }
+      regs_[reg] = data & ~0x07;
+      break;
+    }
+    case I2C_SLV4_CTRL_: {
+      /* I2C_SLV4_EN self clears once the transfer completes */
+      regs_[reg] = data;
+      if (data & 0x80) {
+        slv4_pending_ = true;
+        slv4_done_ns_ = HostTimeNs() + SamplePeriodNs();
+      }
+      break;
+    }
+    case FIFO_R_W_: {
+      break;
+    }
+    default: {
+      /* Status, sensor data, FIFO count, and WHO AM I are read only */
+      bool read_only = ((reg >= I2C_SLV4_DI_) && (reg <= I2C_MST_STATUS_)) ||
+                       ((reg >= INT_STATUS_) && (reg <= 0x60)) ||
+                       (reg == FIFO_COUNT_) || (reg == FIFO_COUNT_ + 1) ||
+                       (reg == WHOAMI_);
+      if (!read_only) {
+        regs_[reg] = data;
+      }
+      break;
+    }
+  }
+}
+uint8_t Mpu9250Sim::ReadRegister(const uint8_t reg) {
+  if (reg >= sizeof(regs_)) {
+    return 0;
+  }
+  uint8_t val = regs_[reg];
+  switch (reg) {
+    case INT_STATUS_:
+    case I2C_MST_STATUS_: {
+      /* Cleared on read */
+      regs_[reg] = 0;
+      break;
+    }
+    case FIFO_COUNT_: {
+      val = static_cast<uint8_t>(fifo_count_ >> 8);
+      break;
+    }
+    case FIFO_COUNT_ + 1: {
+      val = static_cast<uint8_t>(fifo_count_ & 0xFF);
+      break;
+    }
+    case FIFO_R_W_: {
+      val = 0;
+      if (fifo_count_) {
+        val = fifo_[0];
+        fifo_count_--;
+        memmove(fifo_, fifo_ + 1, fifo_count_);
+      }
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+  return val;
+}
+void Mpu9250Sim::WriteAk8963Register(const uint8_t reg, const uint8_t data) {
+  switch (reg) {
+    case AK8963_CNTL1_: {
+      ak_regs_[reg] = data;
+      next_mag_us_ = HostTimeNs() / 1000;
+      /* Self test mode measures the internal field once */
+      if (((data & 0x0F) == 0x08) && (ak_regs_[AK8963_ASTC_] & 0x40)) {
+        for (uint8_t i = 0; i < 3; i++) {
+          ak_regs_[AK8963_HXL_ + 2 * i] = ST_MAG_[i] & 0xFF;
+          ak_regs_[AK8963_HXL_ + 2 * i + 1] =
+            static_cast<uint16_t>(ST_MAG_[i]) >> 8;
+        }
+        ak_regs_[AK8963_ST1_] |= 0x01;
+        ak_regs_[reg] = data & 0x10;
+      }
+      break;
+    }
+    case AK8963_ASTC_: {
+      ak_regs_[reg] = data;
+      break;
+    }
+    case AK8963_CNTL2_: {
+      if (data & 0x01) {
+        ResetAk8963();
+      }
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+}
+uint8_t Mpu9250Sim::ReadAk8963Register(const uint8_t reg) {
+  if (reg >= sizeof(ak_regs_)) {
+    return 0;
+  }
+  uint8_t val = ak_regs_[reg];
+  /* Reading ST2 ends the measurement read and clears DRDY */
+  if (reg == AK8963_ST2_) {
+    ak_regs_[AK8963_ST1_] &= ~0x01;
+  }
+  return val;
+}
+void Mpu9250Sim::CountTransfer(const uint8_t count) {
+  /* The register address byte is sent along with the data */
+  uint64_t bits = (static_cast<uint64_t>(count) + 1) * bits_per_byte_;
+  uint64_t ns = bits * 1000000000ull / clock_hz_;
+  transactions_++;
+  bytes_ += count + 1;
+  bus_time_ns_ += ns;
+  HostAdvanceNs(ns);
+}
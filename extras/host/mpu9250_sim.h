@@ -0,0 +1,146 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef EXTRAS_HOST_MPU9250_SIM_H_
+#define EXTRAS_HOST_MPU9250_SIM_H_
+
+#include "Arduino.h"
+#include "mpu9250_bus.h"
+
+/*
+* Simulated MPU-9250 and AK8963 register map for running the driver on a
+* host computer. Recorded raw samples are replayed at the programmed sample
+* rate, including the I2C master SLV0 / SLV4 channels and the FIFO. SLV4
+* transfers complete one sample period after they are started, as the I2C
+* master runs once per sample. Bus traffic is counted and the host clock is
+* advanced by the transfer time.
+*/
+class Mpu9250Sim : public Mpu9250Bus {
+ public:
+  /* Raw counts in the sensor axis system */
+  struct Record {
+    int16_t accel[3];
+    int16_t temp;
+    int16_t gyro[3];
+    int16_t mag[3];
+  };
+  /*
+  * Transfer time is modeled as (count + 1) bytes of bits_per_byte at
+  * clock_hz, i.e. 8 for SPI and 9 for I2C
+  */
+  explicit Mpu9250Sim(const uint32_t clock_hz = 20000000,
+                      const uint8_t bits_per_byte = 8);
+  void Replay(const Record * const records, const size_t num);
+  void Begin() override;
+  bool WriteRegisters(const uint8_t reg, const uint8_t count,
+                      const uint8_t * const data) override;
+  bool ReadRegisters(const uint8_t reg, const uint8_t count,
+                     uint8_t * const data) override;
+  void ResetCounters();
+  inline uint32_t transactions() const {return transactions_;}
+  inline uint32_t bytes() const {return bytes_;}
+  inline uint64_t bus_time_ns() const {return bus_time_ns_;}
+  inline uint32_t samples() const {return samples_;}
+
+ private:
+  uint32_t clock_hz_;
+  uint8_t bits_per_byte_;
+  /* Replayed data, a level sensor at 16G / 2000DPS if none is given */
+  const Record *records_ = nullptr;
+  size_t num_records_ = 0;
+  size_t record_ = 0;
+  static constexpr Record DEFAULT_RECORD_ = {{0, 0, 2048}, 0, {0, 0, 0},
+                                             {100, 200, 300}};
+  /* Register maps */
+  uint8_t regs_[128];
+  uint8_t ak_regs_[32];
+  uint8_t fifo_[512];
+  size_t fifo_count_ = 0;
+  uint64_t next_sample_ns_ = 0;
+  uint64_t next_mag_us_ = 0;
+  /* SLV4 transfers complete one sample period after they are started */
+  bool slv4_pending_ = false;
+  uint64_t slv4_done_ns_ = 0;
+  /* Counters */
+  uint32_t transactions_ = 0;
+  uint32_t bytes_ = 0;
+  uint64_t bus_time_ns_ = 0;
+  uint32_t samples_ = 0;
+  /* MPU-9250 registers */
+  static constexpr uint8_t SELF_TEST_X_GYRO_ = 0x00;
+  static constexpr uint8_t SELF_TEST_X_ACCEL_ = 0x0D;
+  static constexpr uint8_t SMPLRT_DIV_ = 0x19;
+  static constexpr uint8_t CONFIG_ = 0x1A;
+  static constexpr uint8_t GYRO_CONFIG_ = 0x1B;
+  static constexpr uint8_t ACCEL_CONFIG_ = 0x1C;
+  static constexpr uint8_t FIFO_EN_ = 0x23;
+  static constexpr uint8_t I2C_SLV0_ADDR_ = 0x25;
+  static constexpr uint8_t I2C_SLV0_REG_ = 0x26;
+  static constexpr uint8_t I2C_SLV0_CTRL_ = 0x27;
+  static constexpr uint8_t I2C_SLV4_ADDR_ = 0x31;
+  static constexpr uint8_t I2C_SLV4_REG_ = 0x32;
+  static constexpr uint8_t I2C_SLV4_DO_ = 0x33;
+  static constexpr uint8_t I2C_SLV4_CTRL_ = 0x34;
+  static constexpr uint8_t I2C_SLV4_DI_ = 0x35;
+  static constexpr uint8_t I2C_MST_STATUS_ = 0x36;
+  static constexpr uint8_t INT_PIN_CFG_ = 0x37;
+  static constexpr uint8_t INT_STATUS_ = 0x3A;
+  static constexpr uint8_t ACCEL_OUT_ = 0x3B;
+  static constexpr uint8_t TEMP_OUT_ = 0x41;
+  static constexpr uint8_t GYRO_OUT_ = 0x43;
+  static constexpr uint8_t EXT_SENS_DATA_00_ = 0x49;
+  static constexpr uint8_t USER_CTRL_ = 0x6A;
+  static constexpr uint8_t PWR_MGMNT_1_ = 0x6B;
+  static constexpr uint8_t FIFO_COUNT_ = 0x72;
+  static constexpr uint8_t FIFO_R_W_ = 0x74;
+  static constexpr uint8_t WHOAMI_ = 0x75;
+  /* AK8963 registers */
+  static constexpr uint8_t AK8963_I2C_ADDR_ = 0x0C;
+  static constexpr uint8_t AK8963_ST1_ = 0x02;
+  static constexpr uint8_t AK8963_HXL_ = 0x03;
+  static constexpr uint8_t AK8963_ST2_ = 0x09;
+  static constexpr uint8_t AK8963_CNTL1_ = 0x0A;
+  static constexpr uint8_t AK8963_CNTL2_ = 0x0B;
+  static constexpr uint8_t AK8963_ASTC_ = 0x0C;
+  static constexpr uint8_t AK8963_ASA_ = 0x10;
+  /* Self test responses, matching a factory trim code of 100 */
+  static constexpr uint8_t ST_CODE_ = 100;
+  static constexpr int16_t ST_RESP_ = 7000;
+  static constexpr int16_t ST_MAG_[3] = {30, -40, -1500};
+  void Reset();
+  void ResetAk8963();
+  void Update();
+  uint64_t SamplePeriodNs() const;
+  void Sample(const uint64_t time_us);
+  void FifoPush(const uint8_t * const data, const size_t len);
+  void Slv4Transfer();
+  void WriteRegister(const uint8_t reg, const uint8_t data);
+  uint8_t ReadRegister(const uint8_t reg);
+  void WriteAk8963Register(const uint8_t reg, const uint8_t data);
+  uint8_t ReadAk8963Register(const uint8_t reg);
+  void CountTransfer(const uint8_t count);
+};
+
+#endif  // EXTRAS_HOST_MPU9250_SIM_H_
@@ -26,7 +26,21 @@
 #include "Arduino.h"
 #include "Wire.h"
 #include "SPI.h"
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
 #include "mpu9250.h"
+#include "mpu9250_core.h"
+#include "mpu9250_ring.h"
+#include "mpu9250_bus.h"
+
+Mpu9250 *Mpu9250::drdy_imus_[Mpu9250::MAX_DRDY_] = {};
+void (* const Mpu9250::DRDY_ISRS_[Mpu9250::MAX_DRDY_])() = {
+  Mpu9250::DrdyIsr<0>,
+  Mpu9250::DrdyIsr<1>,
+  Mpu9250::DrdyIsr<2>,
+  Mpu9250::DrdyIsr<3>
+};
 
 Mpu9250::Mpu9250(TwoWire *bus, uint8_t addr) {
   iface_ = I2C;
@@ -38,44 +52,63 @@ Mpu9250::Mpu9250(SPIClass *bus, uint8_t cs) {
   spi_ = bus;
   conn_ = cs;
 }
-bool Mpu9250::Begin() {
+Mpu9250::Mpu9250(Mpu9250Bus *bus) {
+  iface_ = BUS;
+  bus_ = bus;
+  conn_ = 0;
+}
+void Mpu9250::ConfigI2cClock(const uint32_t clock) {
+  i2c_clock_ = clock;
+  /* Takes effect immediately if the bus has already been started */
   if (iface_ == I2C) {
-    i2c_->begin();
-    i2c_->setClock(I2C_CLOCK_);
-  } else {
-    pinMode(conn_, OUTPUT);
-    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
-        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
-        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
-        defined(__IMXRT1052__)
-    digitalWriteFast(conn_, HIGH);
-    #else
-    digitalWrite(conn_, HIGH);
-    #endif
-    spi_->begin();
+    i2c_->setClock(i2c_clock_);
   }
-  spi_clock_ = 1000000;
-  /* Select clock source to gyro */
-  if (!WriteRegister(PWR_MGMNT_1_, CLKSEL_PLL_)) {
+}
+void Mpu9250::ConfigSpiClock(const uint32_t reg_clock,
+                             const uint32_t data_clock) {
+  spi_reg_clock_ = reg_clock;
+  spi_data_clock_ = data_clock;
+  spi_reg_settings_ = SPISettings(spi_reg_clock_, MSBFIRST, SPI_MODE3);
+  spi_data_settings_ = SPISettings(spi_data_clock_, MSBFIRST, SPI_MODE3);
+}
+bool Mpu9250::Begin() {
+  BeginBus();
+  drdy_int_en_ = false;
+  drdy_latch_ = false;
+  wom_en_ = false;
+  /* Reset the MPU-9250 and AK8963 and check their WHO AM I bytes */
+  if (!Mpu9250Core<Mpu9250>::Reset(this, aux_i2c_clock_)) {
     return false;
   }
-  /* Enable I2C master mode */
-  if (!WriteRegister(USER_CTRL_, I2C_MST_EN_)) {
+  /* Get the magnetometer calibration */
+  if (!Mpu9250Core<Mpu9250>::ReadMagScale(this, mag_scale_)) {
     return false;
   }
-  /* Set the I2C bus speed to 400 kHz */
-  if (!WriteRegister(I2C_MST_CTRL_, I2C_MST_CLK_)) {
+  FoldMag();
+  /* Set AK8963 to 16 bit resolution, 100 Hz update rate */
+  if (!ConfigAk8963Mode(AK8963_CNT_MEAS2_)) {
     return false;
   }
-  /* Set AK8963 to power down */
-  WriteAk8963Register(AK8963_CNTL1_, AK8963_PWR_DOWN_);
-  /* Reset the MPU9250 */
-  WriteRegister(PWR_MGMNT_1_, H_RESET_);
-  /* Wait for MPU-9250 to come back up */
-  delay(1);
-  /* Reset the AK8963 */
-  WriteAk8963Register(AK8963_CNTL2_, AK8963_RESET_);
-  /* Select clock source to gyro */
+  /*
+  * Set the default 16G accel range, 2000DPS gyro range, 20HZ DLPF, and an
+  * SRD of 0 in a single burst
+  */
+  if (!WriteImuConfig(ACCEL_RANGE_16G, GYRO_RANGE_2000DPS,
+                      GYRO_BANDWIDTH_20HZ, ACCEL_BANDWIDTH_21HZ, 0)) {
+    return false;
+  }
+  dlpf_bandwidth_ = DLPF_BANDWIDTH_20HZ;
+  /* Get the factory trimmed hardware offsets */
+  if (!ReadHwOffsets()) {
+    return false;
+  }
+  /* Start the stall detection from now */
+  last_sample_us_ = micros();
+  return true;
+}
+bool Mpu9250::Begin(const Profile &profile) {
+  BeginBus();
+  /* Select clock source to gyro, this also wakes the MPU-9250 */
   if (!WriteRegister(PWR_MGMNT_1_, CLKSEL_PLL_)) {
     return false;
   }
@@ -87,14 +120,33 @@ bool Mpu9250::Begin() {
   if ((who_am_i != WHOAMI_MPU9250_) && (who_am_i != WHOAMI_MPU9255_)) {
     return false;
   }
+  /* There is no reset, so undo a wake on motion setup left running */
+  if (!WriteRegister(PWR_MGMNT_2_, SEN_ENABLE_)) {
+    return false;
+  }
+  if (!WriteRegister(MOT_DETECT_CTRL_, 0x00)) {
+    return false;
+  }
+  wom_en_ = false;
+  /* Stop the FIFO, its contents are unknown after a reset */
+  if (!WriteRegister(FIFO_EN_, 0x00)) {
+    return false;
+  }
+  fifo_en_ = 0;
+  fifo_frame_size_ = 0;
   /* Enable I2C master mode */
   if (!WriteRegister(USER_CTRL_, I2C_MST_EN_)) {
     return false;
   }
-  /* Set the I2C bus speed to 400 kHz */
-  if (!WriteRegister(I2C_MST_CTRL_, I2C_MST_CLK_)) {
+  /* Set the auxiliary I2C bus speed */
+  if (!WriteRegister(I2C_MST_CTRL_, aux_i2c_clock_)) {
     return false;
   }
+  /* Run the I2C master at the full rate so the AK8963 is set up quickly */
+  if (!WriteRegister(SMPLRT_DIV_, 0)) {
+    return false;
+  }
+  smplrt_div_ = 0;
   /* Check the AK8963 WHOAMI */
   if (!ReadAk8963Registers(AK8963_WHOAMI_, sizeof(who_am_i), &who_am_i)) {
     return false;
@@ -102,205 +154,210 @@ bool Mpu9250::Begin() {
   if (who_am_i != WHOAMI_AK8963_) {
     return false;
   }
-  /* Get the magnetometer calibration */
-  /* Set AK8963 to power down */
-  if (!WriteAk8963Register(AK8963_CNTL1_, AK8963_PWR_DOWN_)) {
+  /* Use the stored magnetometer calibration instead of the FUSE ROM */
+  mag_scale_[0] = profile.mag_scale[0];
+  mag_scale_[1] = profile.mag_scale[1];
+  mag_scale_[2] = profile.mag_scale[2];
+  FoldMag();
+  /* Set the magnetometer sample rate */
+  if (profile.srd > 9) {
+    /* Set AK8963 to 16 bit resolution, 8 Hz update rate */
+    if (!ConfigAk8963Mode(AK8963_CNT_MEAS1_)) {
+      return false;
+    }
+  } else {
+    /* Set AK8963 to 16 bit resolution, 100 Hz update rate */
+    if (!ConfigAk8963Mode(AK8963_CNT_MEAS2_)) {
+      return false;
+    }
+  }
+  /* Set the ranges, DLPF, and sample rate in a single burst */
+  if (!WriteImuConfig(profile.accel_range, profile.gyro_range,
+                      profile.gyro_bandwidth, profile.accel_bandwidth,
+                      profile.srd)) {
+    return false;
+  }
+  dlpf_bandwidth_ = profile.dlpf;
+  /* Get the hardware offsets, which are retained while powered */
+  if (!ReadHwOffsets()) {
+    return false;
+  }
+  /* Start the stall detection from now */
+  last_sample_us_ = micros();
+  return true;
+}
+Mpu9250::Profile Mpu9250::profile() const {
+  Profile ret;
+  ret.accel_range = accel_range_;
+  ret.gyro_range = gyro_range_;
+  ret.dlpf = dlpf_bandwidth_;
+  ret.srd = srd_;
+  ret.mag_scale[0] = mag_scale_[0];
+  ret.mag_scale[1] = mag_scale_[1];
+  ret.mag_scale[2] = mag_scale_[2];
+  ret.gyro_bandwidth = gyro_bandwidth_;
+  ret.accel_bandwidth = accel_bandwidth_;
+  return ret;
+}
+bool Mpu9250::EnableDrdyInt() {
+  return EnableDrdyInt(false);
+}
+bool Mpu9250::EnableDrdyInt(const bool latch) {
+  /* A latched interrupt is held until any register read clears it */
+  if (!WriteRegister(INT_PIN_CFG_, latch ? INT_LATCH_ANYRD_CLEAR_ :
+                     INT_PULSE_50US_)) {
+    return false;
+  }
+  if (!WriteRegister(INT_ENABLE_, INT_RAW_RDY_EN_)) {
     return false;
   }
-  delay(100);  // long wait between AK8963 mode changes
-  /* Set AK8963 to FUSE ROM access */
-  if (!WriteAk8963Register(AK8963_CNTL1_, AK8963_FUSE_ROM_)) {
+  drdy_latch_ = latch;
+  drdy_new_ = false;
+  drdy_int_en_ = true;
+  return true;
+}
+bool Mpu9250::DisableDrdyInt() {
+  if (!WriteRegister(INT_ENABLE_, INT_DISABLE_)) {
     return false;
   }
-  delay(100);  // long wait between AK8963 mode changes
-  /* Read the AK8963 ASA registers and compute magnetometer scale factors */
-  uint8_t asa_buff[3];
-  if (!ReadAk8963Registers(AK8963_ASA_, sizeof(asa_buff), asa_buff)) {
+  drdy_int_en_ = false;
+  return true;
+}
+bool Mpu9250::EnableWom(const uint16_t threshold_mg, const LpAccelOdr odr) {
+  /* Check input is valid */
+  if (threshold_mg > 1020) {
     return false;
   }
-  mag_scale_[0] = ((static_cast<float>(asa_buff[0]) - 128.0f)
-    / 256.0f + 1.0f) * 4912.0f / 32760.0f;
-  mag_scale_[1] = ((static_cast<float>(asa_buff[1]) - 128.0f)
-    / 256.0f + 1.0f) * 4912.0f / 32760.0f;
-  mag_scale_[2] = ((static_cast<float>(asa_buff[2]) - 128.0f)
-    / 256.0f + 1.0f) * 4912.0f / 32760.0f;
+  switch (odr) {
+    case LP_ACCEL_ODR_0_24HZ:
+    case LP_ACCEL_ODR_0_49HZ:
+    case LP_ACCEL_ODR_0_98HZ:
+    case LP_ACCEL_ODR_1_95HZ:
+    case LP_ACCEL_ODR_3_91HZ:
+    case LP_ACCEL_ODR_7_81HZ:
+    case LP_ACCEL_ODR_15_63HZ:
+    case LP_ACCEL_ODR_31_25HZ:
+    case LP_ACCEL_ODR_62_50HZ:
+    case LP_ACCEL_ODR_125HZ:
+    case LP_ACCEL_ODR_250HZ:
+    case LP_ACCEL_ODR_500HZ: {
+      break;
+    }
+    default: {
+      return false;
+    }
+  }
   /* Set AK8963 to power down */
   if (!WriteAk8963Register(AK8963_CNTL1_, AK8963_PWR_DOWN_)) {
     return false;
   }
-  /* Set AK8963 to 16 bit resolution, 100 Hz update rate */
-  if (!WriteAk8963Register(AK8963_CNTL1_, AK8963_CNT_MEAS2_)) {
+  /* Cycle 0, sleep 0, standby 0 */
+  if (!WriteRegister(PWR_MGMNT_1_, CLKSEL_PLL_)) {
     return false;
   }
-  delay(100);  // long wait between AK8963 mode changes
-  /* Select clock source to gyro */
-  if (!WriteRegister(PWR_MGMNT_1_, CLKSEL_PLL_)) {
+  /* Disable the gyro */
+  if (!WriteRegister(PWR_MGMNT_2_, DIS_GYRO_)) {
     return false;
   }
-  /* Instruct the MPU9250 to get 7 bytes from the AK8963 at the sample rate */
-  uint8_t mag_data[7];
-  if (!ReadAk8963Registers(AK8963_HXL_, sizeof(mag_data), mag_data)) {
+  /* Set the accel bandwidth to 184 Hz */
+  if (!WriteRegister(ACCEL_CONFIG2_, DLPF_BANDWIDTH_184HZ)) {
     return false;
   }
-  /* Set the accel range to 16G by default */
-  if (!ConfigAccelRange(ACCEL_RANGE_16G)) {
+  /* Enable the wake on motion interrupt */
+  if (!WriteRegister(INT_PIN_CFG_, INT_PULSE_50US_)) {
     return false;
   }
-  /* Set the gyro range to 2000DPS by default*/
-  if (!ConfigGyroRange(GYRO_RANGE_2000DPS)) {
+  if (!WriteRegister(INT_ENABLE_, INT_WOM_EN_)) {
     return false;
   }
-  /* Set the DLPF to 20HZ by default */
-  if (!ConfigDlpf(DLPF_BANDWIDTH_20HZ)) {
+  /* Enable accel hardware intelligence, comparing to the previous sample */
+  if (!WriteRegister(MOT_DETECT_CTRL_, ACCEL_INTEL_EN_ | ACCEL_INTEL_MODE_)) {
     return false;
   }
-  /* Set the SRD to 0 by default */
-  if (!ConfigSrd(0)) {
+  /* Set the wake on motion threshold, 4 mg per LSB */
+  if (!WriteRegister(WOM_THR_, static_cast<uint8_t>(threshold_mg / 4))) {
     return false;
   }
-  return true;
-}
-bool Mpu9250::EnableDrdyInt() {
-  spi_clock_ = 1000000;
-  if (!WriteRegister(INT_PIN_CFG_, INT_PULSE_50US_)) {
+  /* Set the frequency of wakeup */
+  if (!WriteRegister(LP_ACCEL_ODR_, odr)) {
     return false;
   }
-  if (!WriteRegister(INT_ENABLE_, INT_RAW_RDY_EN_)) {
+  /* Switch to accel low power mode */
+  if (!WriteRegister(PWR_MGMNT_1_, PWR_CYCLE_ | CLKSEL_PLL_)) {
     return false;
   }
+  wom_en_ = true;
+  wom_threshold_mg_ = threshold_mg;
+  wom_odr_ = odr;
   return true;
 }
-bool Mpu9250::DisableDrdyInt() {
-  spi_clock_ = 1000000;
-  if (!WriteRegister(INT_ENABLE_, INT_DISABLE_)) {
+bool Mpu9250::DisableWom() {
+  /* Leave low power mode and enable the gyro */
+  if (!WriteRegister(PWR_MGMNT_1_, CLKSEL_PLL_)) {
     return false;
   }
-  return true;
+  if (!WriteRegister(PWR_MGMNT_2_, SEN_ENABLE_)) {
+    return false;
+  }
+  if (!WriteRegister(MOT_DETECT_CTRL_, 0x00)) {
+    return false;
+  }
+  /* Restore the data ready interrupt */
+  if (!WriteRegister(INT_PIN_CFG_, drdy_latch_ ? INT_LATCH_ANYRD_CLEAR_ :
+                     INT_PULSE_50US_)) {
+    return false;
+  }
+  if (!WriteRegister(INT_ENABLE_, drdy_int_en_ ? INT_RAW_RDY_EN_ :
+                     INT_DISABLE_)) {
+    return false;
+  }
+  /* Restore the accel bandwidth */
+  if (!WriteRegister(ACCEL_CONFIG2_, accel_bandwidth_)) {
+    return false;
+  }
+  wom_en_ = false;
+  last_sample_us_ = micros();
+  /* Restore the magnetometer, setting it up at the full sample rate */
+  return ConfigSrd(srd_);
 }
 bool Mpu9250::ConfigAccelRange(const AccelRange range) {
-  AccelRange requested_range;
-  float requested_scale;
-  spi_clock_ = 1000000;
-  /* Check input is valid and set requested range and scale */
-  switch (range) {
-    case ACCEL_RANGE_2G: {
-      requested_range = range;
-      requested_scale = 2.0f / 32767.5f;
-      break;
-    }
-    case ACCEL_RANGE_4G: {
-      requested_range = range;
-      requested_scale = 4.0f / 32767.5f;
-      break;
-    }
-    case ACCEL_RANGE_8G: {
-      requested_range = range;
-      requested_scale = 8.0f / 32767.5f;
-      break;
-    }
-    case ACCEL_RANGE_16G: {
-      requested_range = range;
-      requested_scale = 16.0f / 32767.5f;
-      break;
-    }
-    default: {
-      return false;
-    }
+  /* Check input is valid */
+  float requested_scale = AccelScale(range);
+  if (requested_scale == 0.0f) {
+    return false;
   }
   /* Try setting the requested range */
-  if (!WriteRegister(ACCEL_CONFIG_, requested_range)) {
+  if (!WriteRegister(ACCEL_CONFIG_, range)) {
     return false;
   }
   /* Update stored range and scale */
-  accel_range_ = requested_range;
+  accel_range_ = range;
   accel_scale_ = requested_scale;
+  FoldAccel();
   return true;
 }
 bool Mpu9250::ConfigGyroRange(const GyroRange range) {
-  GyroRange requested_range;
-  float requested_scale;
-  spi_clock_ = 1000000;
-  /* Check input is valid and set requested range and scale */
-  switch (range) {
-    case GYRO_RANGE_250DPS: {
-      requested_range = range;
-      requested_scale = 250.0f / 32767.5f;
-      break;
-    }
-    case GYRO_RANGE_500DPS: {
-      requested_range = range;
-      requested_scale = 500.0f / 32767.5f;
-      break;
-    }
-    case GYRO_RANGE_1000DPS: {
-      requested_range = range;
-      requested_scale = 1000.0f / 32767.5f;
-      break;
-    }
-    case GYRO_RANGE_2000DPS: {
-      requested_range = range;
-      requested_scale = 2000.0f / 32767.5f;
-      break;
-    }
-    default: {
-      return false;
-    }
+  /* Check input is valid */
+  float requested_scale = GyroScale(range);
+  if (requested_scale == 0.0f) {
+    return false;
   }
   /* Try setting the requested range */
-  if (!WriteRegister(GYRO_CONFIG_, requested_range)) {
+  /* GYRO_CONFIG also holds the FCHOICE_B bits of the gyro bandwidth */
+  if (!WriteRegister(GYRO_CONFIG_, range | (gyro_bandwidth_ >> 3))) {
     return false;
   }
   /* Update stored range and scale */
-  gyro_range_ = requested_range;
+  gyro_range_ = range;
   gyro_scale_ = requested_scale;
+  FoldGyro();
   return true;
 }
 bool Mpu9250::ConfigSrd(const uint8_t srd) {
-  spi_clock_ = 1000000;
-  /* Changing the SRD to allow us to set the magnetometer successfully */
-  if (!WriteRegister(SMPLRT_DIV_, 19)) {
-    return false;
-  }
-  /* Set the magnetometer sample rate */
-  if (srd > 9) {
-    /* Set AK8963 to power down */
-    WriteAk8963Register(AK8963_CNTL1_, AK8963_PWR_DOWN_);
-    delay(100);  // long wait between AK8963 mode changes
-    /* Set AK8963 to 16 bit resolution, 8 Hz update rate */
-    if (!WriteAk8963Register(AK8963_CNTL1_, AK8963_CNT_MEAS1_)) {
-      return false;
-    }
-    delay(100);  // long wait between AK8963 mode changes
-    /* Instruct the MPU9250 to get 7 bytes from the AK8963 at the sample rate */
-    uint8_t mag_data[7];
-    if (!ReadAk8963Registers(AK8963_HXL_, sizeof(mag_data), mag_data)) {
-      return false;
-    }
-  } else {
-    /* Set AK8963 to power down */
-    WriteAk8963Register(AK8963_CNTL1_, AK8963_PWR_DOWN_);
-    delay(100);  // long wait between AK8963 mode changes
-    /* Set AK8963 to 16 bit resolution, 100 Hz update rate */
-    if (!WriteAk8963Register(AK8963_CNTL1_, AK8963_CNT_MEAS2_)) {
-      return false;
-    }
-    delay(100);  // long wait between AK8963 mode changes
-    /* Instruct the MPU9250 to get 7 bytes from the AK8963 at the sample rate */
-    uint8_t mag_data[7];
-    if (!ReadAk8963Registers(AK8963_HXL_, sizeof(mag_data), mag_data)) {
-      return false;
-    }
-  }
-  /* Set the IMU sample rate */
-  if (!WriteRegister(SMPLRT_DIV_, srd)) {
-    return false;
-  }
-  srd_ = srd;
-  return true;
+  return Mpu9250Core<Mpu9250>::ConfigSrd(this, srd);
 }
 bool Mpu9250::ConfigDlpf(const DlpfBandwidth dlpf) {
   DlpfBandwidth requested_dlpf;
-  spi_clock_ = 1000000;
   /* Check input is valid and set requested dlpf */
   switch (dlpf) {
     case DLPF_BANDWIDTH_184HZ: {
@@ -338,178 +395,1574 @@ bool Mpu9250::ConfigDlpf(const DlpfBandwidth dlpf) {
   if (!WriteRegister(CONFIG_, requested_dlpf)) {
     return false;
   }
+  /* Clear any gyro FCHOICE_B bypass left by ConfigGyroBandwidth */
+  if (gyro_bandwidth_ >> 3) {
+    if (!WriteRegister(GYRO_CONFIG_, gyro_range_)) {
+      return false;
+    }
+  }
   /* Update stored dlpf */
   dlpf_bandwidth_ = requested_dlpf;
+  gyro_bandwidth_ = static_cast<GyroBandwidth>(requested_dlpf);
+  accel_bandwidth_ = static_cast<AccelBandwidth>(requested_dlpf);
   return true;
 }
-void Mpu9250::DrdyCallback(uint8_t int_pin, void (*function)()) {
-  pinMode(int_pin, INPUT);
-  attachInterrupt(int_pin, function, RISING);
-}
-bool Mpu9250::Read() {
-  spi_clock_ = 20000000;
-  /* Read the data registers */
-  uint8_t data_buff[22];
-  if (!ReadRegisters(INT_STATUS_, sizeof(data_buff), data_buff)) {
+bool Mpu9250::ConfigGyroBandwidth(const GyroBandwidth bandwidth) {
+  if (!ValidGyroBandwidth(bandwidth)) {
     return false;
   }
-  /* Check if data is ready */
-  bool data_ready = (data_buff[0] & RAW_DATA_RDY_INT_);
-  if (!data_ready) {
+  /* FCHOICE_B in GYRO_CONFIG bypasses the DLPF_CFG setting in CONFIG */
+  if (!WriteRegister(GYRO_CONFIG_, gyro_range_ | (bandwidth >> 3))) {
+    return false;
+  }
+  if (!WriteRegister(CONFIG_, bandwidth & DLPF_CFG_MASK_)) {
     return false;
   }
-  /* Unpack the buffer */
-  int16_t accel_counts[3], gyro_counts[3], temp_counts, mag_counts[3];
-  accel_counts[0] = static_cast<int16_t>(data_buff[1])  << 8 | data_buff[2];
-  accel_counts[1] = static_cast<int16_t>(data_buff[3])  << 8 | data_buff[4];
-  accel_counts[2] = static_cast<int16_t>(data_buff[5])  << 8 | data_buff[6];
-  temp_counts =     static_cast<int16_t>(data_buff[7])  << 8 | data_buff[8];
-  gyro_counts[0] =  static_cast<int16_t>(data_buff[9])  << 8 | data_buff[10];
-  gyro_counts[1] =  static_cast<int16_t>(data_buff[11]) << 8 | data_buff[12];
-  gyro_counts[2] =  static_cast<int16_t>(data_buff[13]) << 8 | data_buff[14];
-  mag_counts[0] =   static_cast<int16_t>(data_buff[16]) << 8 | data_buff[15];
-  mag_counts[1] =   static_cast<int16_t>(data_buff[18]) << 8 | data_buff[17];
-  mag_counts[2] =   static_cast<int16_t>(data_buff[20]) << 8 | data_buff[19];
-  /* Convert to float values and rotate the accel / gyro axis */
-  accel_mps2_[0] = static_cast<float>(accel_counts[1]) * accel_scale_ *
-                   9.80665f;
-  accel_mps2_[2] = static_cast<float>(accel_counts[2]) * accel_scale_ *
-                   -9.80665f;
-  accel_mps2_[1] = static_cast<float>(accel_counts[0]) * accel_scale_ *
-                   9.80665f;
-  die_temperature_c_ = (static_cast<float>(temp_counts) - 21.0f) / temp_scale_
-                     + 21.0f;
-  gyro_radps_[1] = static_cast<float>(gyro_counts[0]) * gyro_scale_ *
-                   3.14159265358979323846f / 180.0f;
-  gyro_radps_[0] = static_cast<float>(gyro_counts[1]) * gyro_scale_ *
-                   3.14159265358979323846f / 180.0f;
-  gyro_radps_[2] = static_cast<float>(gyro_counts[2]) * gyro_scale_ *
-                   -1.0f * 3.14159265358979323846f / 180.0f;
-  mag_ut_[0] =   static_cast<float>(mag_counts[0]) * mag_scale_[0];
-  mag_ut_[1] =   static_cast<float>(mag_counts[1]) * mag_scale_[1];
-  mag_ut_[2] =   static_cast<float>(mag_counts[2]) * mag_scale_[2];
+  gyro_bandwidth_ = bandwidth;
   return true;
 }
-bool Mpu9250::WriteRegister(uint8_t reg, uint8_t data) {
-  uint8_t ret_val;
-  if (iface_ == I2C) {
-    i2c_->beginTransmission(conn_);
-    i2c_->write(reg);
-    i2c_->write(data);
-    i2c_->endTransmission();
-  } else {
-    spi_->beginTransaction(SPISettings(spi_clock_, MSBFIRST, SPI_MODE3));
-    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
-        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
-        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
-        defined(__IMXRT1052__)
-    digitalWriteFast(conn_, LOW);
-    #else
-    digitalWrite(conn_, LOW);
-    #endif
-    #if defined(__IMXRT1062__)
-      delayNanoseconds(200);
-    #endif
-    spi_->transfer(reg);
-    spi_->transfer(data);
-    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
-        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
-        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
-        defined(__IMXRT1052__)
-    digitalWriteFast(conn_, HIGH);
-    #else
-    digitalWrite(conn_, HIGH);
-    #endif
-    #if defined(__IMXRT1062__)
-      delayNanoseconds(200);
-    #endif
-    spi_->endTransaction();
+bool Mpu9250::ConfigAccelBandwidth(const AccelBandwidth bandwidth) {
+  if (!ValidAccelBandwidth(bandwidth)) {
+    return false;
   }
-  delay(10);
-  ReadRegisters(reg, sizeof(ret_val), &ret_val);
-  if (data == ret_val) {
-    return true;
-  } else {
+  /* ACCEL_FCHOICE_B and A_DLPF_CFG are both in ACCEL_CONFIG2 */
+  if (!WriteRegister(ACCEL_CONFIG2_, bandwidth)) {
     return false;
   }
+  accel_bandwidth_ = bandwidth;
+  return true;
 }
-bool Mpu9250::ReadRegisters(uint8_t reg, uint8_t count, uint8_t *data) {
-  if (iface_ == I2C) {
-    i2c_->beginTransmission(conn_);
-    i2c_->write(reg);
-    i2c_->endTransmission(false);
-    uint8_t bytes_rx = i2c_->requestFrom(conn_, count);
-    if (bytes_rx == count) {
-      for (int i = 0; i < count; i++) {
-        data[i] = i2c_->read();
-      }
-      return true;
-    } else {
+bool Mpu9250::ConfigImu(const AccelRange accel_range,
+                        const GyroRange gyro_range,
+                        const DlpfBandwidth dlpf, const uint8_t srd) {
+  /* Check every input before anything is written */
+  if ((AccelScale(accel_range) == 0.0f) || (GyroScale(gyro_range) == 0.0f)) {
+    return false;
+  }
+  /* The accel and gyro DLPF settings match for each DlpfBandwidth */
+  if ((dlpf < DLPF_BANDWIDTH_184HZ) || (dlpf > DLPF_BANDWIDTH_5HZ)) {
+    return false;
+  }
+  /* The magnetometer rate changes between 100 Hz and 8 Hz at an SRD of 9 */
+  if ((srd > 9) != (srd_ > 9)) {
+    if (!ConfigSrd(srd)) {
       return false;
     }
-  } else {
-    spi_->beginTransaction(SPISettings(spi_clock_, MSBFIRST, SPI_MODE3));
-    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
-        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
-        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
-        defined(__IMXRT1052__)
-    digitalWriteFast(conn_, LOW);
-    #else
-    digitalWrite(conn_, LOW);
-    #endif
-    #if defined(__IMXRT1062__)
-      delayNanoseconds(200);
-    #endif
-    spi_->transfer(reg | SPI_READ_);
-    spi_->transfer(data, count);
-    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
-        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
-        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
-        defined(__IMXRT1052__)
-    digitalWriteFast(conn_, HIGH);
-    #else
-    digitalWrite(conn_, LOW);
-    #endif
-    #if defined(__IMXRT1062__)
-      delayNanoseconds(200);
-    #endif
-    spi_->endTransaction();
-    return true;
   }
-}
-bool Mpu9250::WriteAk8963Register(uint8_t reg, uint8_t data) {
-  uint8_t ret_val;
-  if (!WriteRegister(I2C_SLV0_ADDR_, AK8963_I2C_ADDR_)) {
+  if (!WriteImuConfig(accel_range, gyro_range,
+                      static_cast<GyroBandwidth>(dlpf),
+                      static_cast<AccelBandwidth>(dlpf), srd)) {
     return false;
   }
-  if (!WriteRegister(I2C_SLV0_REG_, reg)) {
+  dlpf_bandwidth_ = dlpf;
+  return true;
+}
+bool Mpu9250::ConfigAuxI2cClock(const AuxI2cClock clock) {
+  if (clock > AUX_I2C_CLOCK_364KHZ) {
     return false;
   }
-  if (!WriteRegister(I2C_SLV0_DO_, data)) {
+  if (!WriteRegister(I2C_MST_CTRL_, clock)) {
     return false;
   }
-  if (!WriteRegister(I2C_SLV0_CTRL_, I2C_SLV0_EN_ | sizeof(data))) {
-    return false;
+  aux_i2c_clock_ = clock;
+  return true;
+}
+bool Mpu9250::ConfigHwOffsets(const HwOffsets &offsets) {
+  static const uint8_t gyro_regs[3] = {XG_OFFSET_H_, YG_OFFSET_H_,
+                                       ZG_OFFSET_H_};
+  static const uint8_t accel_regs[3] = {XA_OFFSET_H_, YA_OFFSET_H_,
+                                        ZA_OFFSET_H_};
+  /* Check every input before the first write, so none are half applied */
+  for (uint8_t i = 0; i < 3; i++) {
+    if ((offsets.accel[i] < ACCEL_OFFSET_MIN_) ||
+        (offsets.accel[i] > ACCEL_OFFSET_MAX_)) {
+      return false;
+    }
   }
-  if (!ReadAk8963Registers(reg, sizeof(ret_val), &ret_val)) {
-    return false;
+  /* The accel offset is bits 15:1, bit 0 is reserved and must be preserved */
+  uint8_t accel_low[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    if (!ReadRegisters(accel_regs[i] + 1, sizeof(accel_low[i]),
+                       &accel_low[i])) {
+      return false;
+    }
   }
-  if (data == ret_val) {
-    return true;
-  } else {
+  bool status = true;
+  for (uint8_t i = 0; (status) && (i < 3); i++) {
+    status = (WriteRegister(gyro_regs[i],
+                            static_cast<uint16_t>(offsets.gyro[i]) >> 8)) &&
+             (WriteRegister(gyro_regs[i] + 1, offsets.gyro[i] & 0xFF));
+  }
+  for (uint8_t i = 0; (status) && (i < 3); i++) {
+    uint16_t reg = static_cast<uint16_t>(offsets.accel[i]) << 1 |
+                   (accel_low[i] & 0x01);
+    status = (WriteRegister(accel_regs[i], reg >> 8)) &&
+             (WriteRegister(accel_regs[i] + 1, reg & 0xFF));
+  }
+  /* A failed write may have applied some offsets, so track what was applied */
+  if (!status) {
+    ReadHwOffsets();
     return false;
   }
+  hw_offsets_ = offsets;
+  return true;
 }
-bool Mpu9250::ReadAk8963Registers(uint8_t reg, uint8_t count, uint8_t *data) {
-  if (!WriteRegister(I2C_SLV0_ADDR_, AK8963_I2C_ADDR_ | I2C_READ_FLAG_)) {
-    return false;
+bool Mpu9250::CalibrateHwOffsets() {
+  /* Average the data with the sensor at rest and level */
+  int32_t accel_sum[3] = {}, gyro_sum[3] = {};
+  uint16_t num_samples = 0;
+  uint32_t timeout_ms = CAL_SAMPLES_ * 2 * (SamplePeriodNs() / 1000000) + 100;
+  uint32_t start_ms = millis();
+  while (num_samples < CAL_SAMPLES_) {
+    if (millis() - start_ms > timeout_ms) {
+      return false;
+    }
+    if (ReadRaw()) {
+      for (uint8_t i = 0; i < 3; i++) {
+        accel_sum[i] += accel_cnts_[i];
+        gyro_sum[i] += gyro_cnts_[i];
+      }
+      num_samples++;
+    }
   }
-  if (!WriteRegister(I2C_SLV0_REG_, reg)) {
-    return false;
+  /* Sensor axis in the common axis system order */
+  static const uint8_t sensor_axis[3] = {1, 0, 2};
+  static const float sensor_sign[3] = {1.0f, 1.0f, -1.0f};
+  /* At rest and level, the sensor z axis measures +1g */
+  static const float expected_g[3] = {0.0f, 0.0f, 1.0f};
+  HwOffsets offsets = hw_offsets_;
+  for (uint8_t i = 0; i < 3; i++) {
+    /* Rotate the averages back from the common axis system */
+    uint8_t axis = sensor_axis[i];
+    float gyro_mean = sensor_sign[i] * static_cast<float>(gyro_sum[i]) /
+                      static_cast<float>(num_samples);
+    float accel_mean = sensor_sign[i] * static_cast<float>(accel_sum[i]) /
+                       static_cast<float>(num_samples);
+    /* Offsets are added to the sensor data, so remove the measured bias */
+    float gyro_bias_dps = gyro_mean * gyro_scale_;
+    float accel_bias_g = accel_mean * accel_scale_ - expected_g[axis];
+    int32_t gyro_offset = hw_offsets_.gyro[axis] -
+                          Round(gyro_bias_dps * GYRO_OFFSET_LSB_PER_DPS_);
+    int32_t accel_offset = hw_offsets_.accel[axis] -
+                           Round(accel_bias_g * ACCEL_OFFSET_LSB_PER_G_);
+    offsets.gyro[axis] = Clamp(gyro_offset, -32768, 32767);
+    offsets.accel[axis] = Clamp(accel_offset, ACCEL_OFFSET_MIN_,
+                                ACCEL_OFFSET_MAX_);
   }
-  if (!WriteRegister(I2C_SLV0_CTRL_, I2C_SLV0_EN_ | count)) {
+  return ConfigHwOffsets(offsets);
+}
+bool Mpu9250::SelfTest(SelfTestResult * const result) {
+  if ((!result) || (fifo_en_) || (wom_en_)) {
     return false;
   }
-  delay(1);
-  return ReadRegisters(EXT_SENS_DATA_00_, count, data);
+  *result = SelfTestResult();
+  /* Store the configuration to restore afterwards */
+  const AccelRange accel_range = accel_range_;
+  const GyroRange gyro_range = gyro_range_;
+  const GyroBandwidth gyro_bandwidth = gyro_bandwidth_;
+  const AccelBandwidth accel_bandwidth = accel_bandwidth_;
+  const uint8_t srd = srd_;
+  /* 1 kHz, 92 Hz DLPF, 250 dps and 2 g full scale */
+  bool status = WriteImuConfig(ACCEL_RANGE_2G, GYRO_RANGE_250DPS,
+                               GYRO_BANDWIDTH_92HZ, ACCEL_BANDWIDTH_99HZ, 0);
+  int32_t accel_os[3], gyro_os[3], accel_st[3], gyro_st[3];
+  if (status) {
+    delay(ST_SETTLE_MS_);
+    status = SelfTestAverage(accel_os, gyro_os);
+  }
+  /* Enable the self test on all accel and gyro axes */
+  if (status) {
+    status = (WriteRegister(GYRO_CONFIG_, XYZ_SELF_TEST_EN_ |
+                            GYRO_RANGE_250DPS)) &&
+             (WriteRegister(ACCEL_CONFIG_, XYZ_SELF_TEST_EN_ |
+                            ACCEL_RANGE_2G));
+  }
+  if (status) {
+    delay(ST_SETTLE_MS_);
+    status = SelfTestAverage(accel_st, gyro_st);
+  }
+  /* Disable the self test and let the outputs settle */
+  WriteRegister(GYRO_CONFIG_, GYRO_RANGE_250DPS);
+  WriteRegister(ACCEL_CONFIG_, ACCEL_RANGE_2G);
+  delay(ST_SETTLE_MS_);
+  /* Factory trim codes */
+  uint8_t gyro_code[3], accel_code[3];
+  if (status) {
+    status = (ReadRegisters(SELF_TEST_X_GYRO_, sizeof(gyro_code), gyro_code))
+             && (ReadRegisters(SELF_TEST_X_ACCEL_, sizeof(accel_code),
+                 accel_code));
+  }
+  if (status) {
+    for (uint8_t i = 0; i < 3; i++) {
+      float gyro_resp = static_cast<float>(gyro_st[i] - gyro_os[i]);
+      float accel_resp = static_cast<float>(accel_st[i] - accel_os[i]);
+      float gyro_os_lsb = fabsf(static_cast<float>(gyro_os[i]));
+      if (gyro_code[i]) {
+        float otp = ST_OTP_BASE_ * powf(1.01f, gyro_code[i] - 1.0f);
+        result->gyro_ratio[i] = gyro_resp / otp;
+        result->gyro_pass[i] = (result->gyro_ratio[i] > ST_GYRO_MIN_RATIO_);
+      } else {
+        result->gyro_ratio[i] = 0.0f;
+        result->gyro_pass[i] = (fabsf(gyro_resp) >= ST_GYRO_MIN_LSB_);
+      }
+      result->gyro_pass[i] = (result->gyro_pass[i]) &&
+                             (gyro_os_lsb <= ST_GYRO_MAX_OFFSET_LSB_);
+      if (accel_code[i]) {
+        float otp = ST_OTP_BASE_ * powf(1.01f, accel_code[i] - 1.0f);
+        result->accel_ratio[i] = accel_resp / otp;
+        result->accel_pass[i] =
+          (result->accel_ratio[i] > ST_ACCEL_MIN_RATIO_) &&
+          (result->accel_ratio[i] < ST_ACCEL_MAX_RATIO_);
+      } else {
+        result->accel_ratio[i] = 0.0f;
+        result->accel_pass[i] = (fabsf(accel_resp) >= ST_ACCEL_MIN_LSB_) &&
+                                (fabsf(accel_resp) <= ST_ACCEL_MAX_LSB_);
+      }
+    }
+  }
+  /*
+  * The magnetometer test stops sampling, SelfTestMag restores it, while the
+  * SRD is still 0 so each AK8963 transaction takes at most 1 ms
+  */
+  if (!SelfTestMag(result->mag_cnts, srd)) {
+    status = false;
+  }
+  /* Restore the accel and gyro configuration */
+  if (!WriteImuConfig(accel_range, gyro_range, gyro_bandwidth,
+                      accel_bandwidth, srd)) {
+    status = false;
+  }
+  if (!status) {
+    return false;
+  }
+  result->mag_pass[0] = (result->mag_cnts[0] >= -ST_MAG_XY_LIMIT_) &&
+                        (result->mag_cnts[0] <= ST_MAG_XY_LIMIT_);
+  result->mag_pass[1] = (result->mag_cnts[1] >= -ST_MAG_XY_LIMIT_) &&
+                        (result->mag_cnts[1] <= ST_MAG_XY_LIMIT_);
+  result->mag_pass[2] = (result->mag_cnts[2] >= ST_MAG_Z_MIN_) &&
+                        (result->mag_cnts[2] <= ST_MAG_Z_MAX_);
+  for (uint8_t i = 0; i < 3; i++) {
+    if ((!result->accel_pass[i]) || (!result->gyro_pass[i]) ||
+        (!result->mag_pass[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+bool Mpu9250::SelfTestAverage(int32_t accel[3], int32_t gyro[3]) {
+  /* Sensor axis averages, one read per 1 kHz sample */
+  for (uint8_t i = 0; i < 3; i++) {
+    accel[i] = 0;
+    gyro[i] = 0;
+  }
+  uint8_t data_buff[14];
+  for (uint8_t n = 0; n < ST_SAMPLES_; n++) {
+    delayMicroseconds(1000);
+    if (!ReadRegisters(INT_STATUS_ + 1, sizeof(data_buff), data_buff,
+                       spi_data_settings_)) {
+      return false;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+      accel[i] += static_cast<int16_t>(data_buff[2 * i] << 8 |
+                                       data_buff[2 * i + 1]);
+      gyro[i] += static_cast<int16_t>(data_buff[2 * i + 8] << 8 |
+                                      data_buff[2 * i + 9]);
+    }
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    accel[i] /= ST_SAMPLES_;
+    gyro[i] /= ST_SAMPLES_;
+  }
+  return true;
+}
+bool Mpu9250::SelfTestMag(float mag_cnts[3], const uint8_t srd) {
+  /* Stop SLV0 sampling, its ST2 reads would clear DRDY */
+  bool status = WriteRegister(I2C_SLV0_CTRL_, 0x00);
+  if (status) {
+    status = (WriteAk8963Register(AK8963_CNTL1_, AK8963_PWR_DOWN_)) &&
+             (WriteAk8963Register(AK8963_ASTC_, AK8963_SELF_));
+  }
+  /* CNTL1 returns to power down when the measurement completes */
+  if (status) {
+    status = WriteAk8963Register(AK8963_CNTL1_, AK8963_SELF_TEST_16BIT_,
+                                 WRITE_VERIFY_NONE);
+  }
+  uint8_t st1 = 0;
+  uint32_t t0 = millis();
+  while ((status) && (!(st1 & AK8963_DRDY_))) {
+    if (millis() - t0 > ST_MAG_TIMEOUT_MS_) {
+      status = false;
+      break;
+    }
+    status = ReadAk8963Registers(AK8963_ST1_, sizeof(st1), &st1);
+  }
+  /* HXL through ST2, reading ST2 ends the measurement */
+  uint8_t data_buff[AK8963_ST2_ - AK8963_HXL_ + 1];
+  if (status) {
+    status = ReadAk8963Registers(AK8963_HXL_, sizeof(data_buff), data_buff);
+  }
+  if (status) {
+    for (uint8_t i = 0; i < 3; i++) {
+      int16_t cnts = static_cast<int16_t>(data_buff[2 * i + 1]) << 8 |
+                     data_buff[2 * i];
+      /* Sensitivity adjustment, removing the uT conversion */
+      mag_cnts[i] = static_cast<float>(cnts) * mag_scale_[i] * 32760.0f /
+                    4912.0f;
+    }
+  }
+  /* Leave self test and restore continuous measurement */
+  if (!WriteAk8963Register(AK8963_ASTC_, 0x00)) {
+    status = false;
+  }
+  /* The magnetometer rate follows the SRD that is restored afterwards */
+  if (!ConfigAk8963Mode((srd > 9) ? AK8963_CNT_MEAS1_ : AK8963_CNT_MEAS2_)) {
+    status = false;
+  }
+  return status;
+}
+void Mpu9250::ConfigWriteVerify(const WriteVerify verify) {
+  write_verify_ = verify;
+}
+void Mpu9250::DrdyCallback(uint8_t int_pin, void (*function)()) {
+  drdy_callback_ = function;
+  pinMode(int_pin, INPUT);
+  /* Timestamp samples with a library ISR if a slot is available */
+  uint8_t slot = MAX_DRDY_;
+  for (uint8_t i = 0; i < MAX_DRDY_; i++) {
+    if (drdy_imus_[i] == this) {
+      slot = i;
+      break;
+    }
+    if ((!drdy_imus_[i]) && (slot == MAX_DRDY_)) {
+      slot = i;
+    }
+  }
+  if (slot < MAX_DRDY_) {
+    drdy_imus_[slot] = this;
+    drdy_attached_ = true;
+    attachInterrupt(int_pin, DRDY_ISRS_[slot], RISING);
+  } else if (function) {
+    attachInterrupt(int_pin, function, RISING);
+  }
+}
+void Mpu9250::DrdyHandler() {
+  drdy_time_us_ = micros();
+  drdy_new_ = true;
+  #if defined(MPU9250_STATS)
+  /* The previous sample wasn't read before this one, FIFO and WOM excepted */
+  if ((drdy_pending_) && (!fifo_en_) && (!wom_en_)) {
+    stats_.missed_drdy++;
+  }
+  drdy_pending_ = true;
+  #endif
+  if (drdy_callback_) {
+    drdy_callback_();
+  }
+}
+#if defined(MPU9250_STATS)
+Mpu9250::Stats Mpu9250::stats() const {
+  #if defined(__AVR__)
+  /* missed_drdy is updated from the ISR, 32 bit reads aren't atomic */
+  Stats s;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    s = stats_;
+  }
+  return s;
+  #else
+  return stats_;
+  #endif
+}
+void Mpu9250::ResetStats() {
+  noInterrupts();
+  stats_ = {};
+  drdy_pending_ = false;
+  interrupts();
+}
+#endif
+uint32_t Mpu9250::SampleTime(const uint32_t read_time_us) {
+  if (!drdy_attached_) {
+    return read_time_us;
+  }
+  #if defined(__AVR__)
+  /* 32 bit reads aren't atomic on 8 bit platforms */
+  uint32_t t;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    t = drdy_time_us_;
+  }
+  return t;
+  #else
+  return drdy_time_us_;
+  #endif
+}
+uint32_t Mpu9250::SamplePeriodNs() const {
+  /* The gyro DLPF bypass modes run at 32 kHz or 8 kHz, ignoring the SRD */
+  if (gyro_bandwidth_ >> 3) {
+    return 31250;
+  }
+  if (gyro_bandwidth_ == GYRO_BANDWIDTH_250HZ) {
+    return 125000;
+  }
+  return (static_cast<uint32_t>(srd_) + 1) * 1000000;
+}
+bool Mpu9250::Read() {
+  if (!ReadRaw()) {
+    return false;
+  }
+  Convert();
+  return true;
+}
+bool Mpu9250::ReadRaw() {
+  #if defined(SPI_HAS_TRANSFER_ASYNC)
+  /* The bus is in use by an asynchronous read, which isn't a bus fault */
+  if (async_busy_) {
+    return false;
+  }
+  #endif
+  /* With the library DRDY ISR, skip the bus if there's no new sample */
+  bool drdy_gated = (drdy_attached_) && (drdy_int_en_) && (!wom_en_);
+  if (drdy_gated) {
+    if (!drdy_new_) {
+      return false;
+    }
+    drdy_new_ = false;
+  }
+  uint32_t read_time_us = micros();
+  /* Read the data registers */
+  uint8_t data_buff[DATA_LEN_];
+  /*
+  * A latched interrupt clears INT_STATUS on any read, so the ISR stands in
+  * for it and the read starts at the accel data
+  */
+  uint8_t start = 0;
+  if ((drdy_gated) && (drdy_latch_)) {
+    data_buff[0] = RAW_DATA_RDY_INT_;
+    start = 1;
+  }
+  if (mag_read_on_drdy_) {
+    /* Read through the AK8963 ST1 byte and get the mag only if it's new */
+    if (!ReadRegisters(INT_STATUS_ + start, IMU_DATA_LEN_ - start,
+                       data_buff + start, spi_data_settings_)) {
+      RecordFault(FAULT_BUS);
+      return false;
+    }
+    if (!(data_buff[0] & RAW_DATA_RDY_INT_)) {
+      #if defined(MPU9250_STATS)
+      stats_.reads++;
+      stats_.no_data++;
+      #endif
+      CheckData(data_buff);
+      return false;
+    }
+    if (data_buff[IMU_DATA_LEN_ - 1] & AK8963_DRDY_) {
+      if (!ReadRegisters(INT_STATUS_ + IMU_DATA_LEN_,
+                         DATA_LEN_ - IMU_DATA_LEN_,
+                         data_buff + IMU_DATA_LEN_, spi_data_settings_)) {
+        RecordFault(FAULT_BUS);
+        return false;
+      }
+    }
+  } else {
+    if (!ReadRegisters(INT_STATUS_ + start, sizeof(data_buff) - start,
+                       data_buff + start, spi_data_settings_)) {
+      RecordFault(FAULT_BUS);
+      return false;
+    }
+  }
+  #if defined(MPU9250_STATS)
+  uint32_t read_us = micros() - read_time_us;
+  if (read_us > stats_.max_read_us) {
+    stats_.max_read_us = read_us;
+  }
+  stats_.total_read_us += read_us;
+  #endif
+  if (!CheckData(data_buff)) {
+    return false;
+  }
+  if (!UnpackData(data_buff)) {
+    return false;
+  }
+  time_us_ = SampleTime(read_time_us);
+  /* Periodically check that the sensor hasn't been reset or replaced */
+  if ((auto_recover_) && (++spot_check_reads_ >= SPOT_CHECK_READS_)) {
+    SpotCheck();
+  }
+  return true;
+}
+#if defined(SPI_HAS_TRANSFER_ASYNC)
+bool Mpu9250::ReadAsync() {
+  /* A synchronous transaction may have been interrupted mid transfer */
+  if ((iface_ != SPI) || (async_busy_) || (sync_busy_)) {
+    return false;
+  }
+  async_busy_ = true;
+  async_event_.setContext(this);
+  async_event_.attachImmediate(AsyncEventHandler);
+  async_tx_buff_[0] = INT_STATUS_ | SPI_READ_;
+  /* Timestamp now, the data ready time may change before it's unpacked */
+  async_time_us_ = SampleTime(micros());
+  spi_->beginTransaction(spi_data_settings_);
+  #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+      defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+      defined(__IMXRT1052__)
+  digitalWriteFast(conn_, LOW);
+  #else
+  digitalWrite(conn_, LOW);
+  #endif
+  #if defined(__IMXRT1062__)
+    delayNanoseconds(200);
+  #endif
+  /* Unpacking is done by the event handler once the DMA transfer completes */
+  if (!spi_->transfer(async_tx_buff_, async_rx_buff_, sizeof(async_rx_buff_),
+                      async_event_)) {
+    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+        defined(__IMXRT1052__)
+    digitalWriteFast(conn_, HIGH);
+    #else
+    digitalWrite(conn_, HIGH);
+    #endif
+    spi_->endTransaction();
+    async_busy_ = false;
+    return false;
+  }
+  return true;
+}
+bool Mpu9250::AsyncReadComplete() {
+  /* A recovery deferred while a transfer had the bus runs once it's free */
+  if ((recover_pending_) && (!async_busy_)) {
+    recover_pending_ = false;
+    Recover();
+  }
+  if (!async_new_data_) {
+    return false;
+  }
+  /*
+  * The object is only updated here, in the main context, so its data can't
+  * change between getters; the staged copy is taken with interrupts off
+  * since the next transfer may complete at any time
+  */
+  uint8_t data_buff[DATA_LEN_];
+  noInterrupts();
+  memcpy(data_buff, async_data_buff_, sizeof(data_buff));
+  uint32_t time_us = async_data_time_us_;
+  async_new_data_ = false;
+  interrupts();
+  if (!CheckData(data_buff)) {
+    return false;
+  }
+  if (!UnpackData(data_buff)) {
+    return false;
+  }
+  time_us_ = time_us;
+  Convert();
+  return true;
+}
+void Mpu9250::AsyncReadCallback(void (*function)()) {
+  async_callback_ = function;
+}
+void Mpu9250::AsyncEventHandler(EventResponderRef event) {
+  Mpu9250 *imu = static_cast<Mpu9250 *>(event.getContext());
+  #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+      defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+      defined(__IMXRT1052__)
+  digitalWriteFast(imu->conn_, HIGH);
+  #else
+  digitalWrite(imu->conn_, HIGH);
+  #endif
+  #if defined(__IMXRT1062__)
+    delayNanoseconds(200);
+  #endif
+  imu->spi_->endTransaction();
+  /*
+  * The first received byte is clocked out during the register address. The
+  * data is only staged here, AsyncReadComplete checks and unpacks it
+  */
+  memcpy(imu->async_data_buff_, imu->async_rx_buff_ + 1,
+         sizeof(imu->async_data_buff_));
+  imu->async_data_time_us_ = imu->async_time_us_;
+  imu->async_new_data_ = true;
+  imu->async_busy_ = false;
+  if (imu->async_callback_) {
+    imu->async_callback_();
+  }
+}
+#endif
+bool Mpu9250::UnpackData(const uint8_t * const data_buff) {
+  /* Check if data is ready */
+  bool data_ready = (data_buff[0] & RAW_DATA_RDY_INT_);
+  #if defined(MPU9250_STATS)
+  stats_.reads++;
+  if (!data_ready) {
+    stats_.no_data++;
+  } else {
+    drdy_pending_ = false;
+  }
+  #endif
+  if (!data_ready) {
+    return false;
+  }
+  /* Unpack the buffer and rotate the accel / gyro axis */
+  accel_cnts_[1] = static_cast<int16_t>(data_buff[1])  << 8 | data_buff[2];
+  accel_cnts_[0] = static_cast<int16_t>(data_buff[3])  << 8 | data_buff[4];
+  accel_cnts_[2] = Negate(static_cast<int16_t>(data_buff[5]) << 8 |
+                          data_buff[6]);
+  temp_cnts_ =     static_cast<int16_t>(data_buff[7])  << 8 | data_buff[8];
+  gyro_cnts_[1] =  static_cast<int16_t>(data_buff[9])  << 8 | data_buff[10];
+  gyro_cnts_[0] =  static_cast<int16_t>(data_buff[11]) << 8 | data_buff[12];
+  gyro_cnts_[2] =  Negate(static_cast<int16_t>(data_buff[13]) << 8 |
+                          data_buff[14]);
+  new_mag_data_ = (data_buff[15] & AK8963_DRDY_);
+  if ((new_mag_data_) || (!mag_read_on_drdy_)) {
+    mag_cnts_[0] = static_cast<int16_t>(data_buff[17]) << 8 | data_buff[16];
+    mag_cnts_[1] = static_cast<int16_t>(data_buff[19]) << 8 | data_buff[18];
+    mag_cnts_[2] = static_cast<int16_t>(data_buff[21]) << 8 | data_buff[20];
+  }
+  return true;
+}
+bool Mpu9250::EnableFifo(const bool accel, const bool gyro, const bool mag,
+                         const bool temp) {
+  uint8_t requested_en = 0;
+  uint8_t requested_frame_size = 0;
+  /* Frames are stored in register order: accel, temp, gyro, then mag */
+  if (accel) {
+    requested_en |= FIFO_ACCEL_EN_;
+    requested_frame_size += 6;
+  }
+  if (temp) {
+    requested_en |= FIFO_TEMP_EN_;
+    requested_frame_size += 2;
+  }
+  if (gyro) {
+    requested_en |= FIFO_GYRO_EN_;
+    requested_frame_size += 6;
+  }
+  if (mag) {
+    requested_en |= FIFO_SLV0_EN_;
+    requested_frame_size += 8;
+  }
+  if (!requested_en) {
+    return false;
+  }
+  /* Stop sensors from writing to the FIFO while it is configured */
+  if (!WriteRegister(FIFO_EN_, 0x00)) {
+    return false;
+  }
+  if (!WriteRegister(USER_CTRL_, I2C_MST_EN_ | USER_FIFO_EN_)) {
+    return false;
+  }
+  if (!ResetFifo()) {
+    return false;
+  }
+  if (!WriteRegister(FIFO_EN_, requested_en)) {
+    return false;
+  }
+  fifo_en_ = requested_en;
+  fifo_frame_size_ = requested_frame_size;
+  fifo_num_frames_ = 0;
+  return true;
+}
+bool Mpu9250::DisableFifo() {
+  if (!WriteRegister(FIFO_EN_, 0x00)) {
+    return false;
+  }
+  if (!WriteRegister(USER_CTRL_, I2C_MST_EN_)) {
+    return false;
+  }
+  fifo_en_ = 0;
+  fifo_frame_size_ = 0;
+  fifo_num_frames_ = 0;
+  return true;
+}
+bool Mpu9250::ResetFifo() {
+  uint8_t user_ctrl;
+  /* FIFO_RST self clears, so the write is checked by reading back below */
+  WriteRegister(USER_CTRL_, I2C_MST_EN_ | USER_FIFO_EN_ | FIFO_RST_,
+                WRITE_VERIFY_NONE);
+  if (!ReadRegisters(USER_CTRL_, sizeof(user_ctrl), &user_ctrl)) {
+    return false;
+  }
+  fifo_num_frames_ = 0;
+  return (user_ctrl == (I2C_MST_EN_ | USER_FIFO_EN_));
+}
+bool Mpu9250::ReadFifo(uint8_t * const data, const size_t len) {
+  fifo_num_frames_ = 0;
+  fifo_overflow_ = false;
+  if ((!data) || (!fifo_frame_size_)) {
+    return false;
+  }
+  #if defined(SPI_HAS_TRANSFER_ASYNC)
+  if (async_busy_) {
+    return false;
+  }
+  #endif
+  /* The newest frame in the FIFO is from the latest data ready */
+  uint32_t newest_time_us = SampleTime(micros());
+  /* Get the number of bytes stored in the FIFO */
+  uint8_t count_buff[2];
+  if (!ReadRegisters(FIFO_COUNT_, sizeof(count_buff), count_buff,
+                     spi_data_settings_)) {
+    RecordFault(FAULT_BUS);
+    return false;
+  }
+  size_t fifo_count = static_cast<size_t>(count_buff[0] & 0x1F) << 8 |
+                      count_buff[1];
+  /* A full FIFO has overwritten the oldest bytes and lost frame alignment */
+  if (fifo_count >= FIFO_SIZE_) {
+    fifo_overflow_ = true;
+    #if defined(MPU9250_STATS)
+    stats_.fifo_overflows++;
+    #endif
+    ResetFifo();
+    return false;
+  }
+  size_t num_frames = fifo_count / fifo_frame_size_;
+  /* Back compute the time of the oldest frame from the sample period */
+  if (num_frames) {
+    fifo_time_us_ = newest_time_us - static_cast<uint32_t>(
+      static_cast<uint64_t>(num_frames - 1) * SamplePeriodNs() / 1000);
+  }
+  if (num_frames > len / fifo_frame_size_) {
+    num_frames = len / fifo_frame_size_;
+  }
+  if (!num_frames) {
+    return false;
+  }
+  /* Drain whole frames in as few bursts as the bus buffers allow */
+  size_t max_burst = (iface_ == I2C) ? I2C_MAX_BURST_ : SPI_MAX_BURST_;
+  size_t burst_frames = max_burst / fifo_frame_size_;
+  size_t frames_read = 0;
+  while (frames_read < num_frames) {
+    size_t frames = num_frames - frames_read;
+    if (frames > burst_frames) {
+      frames = burst_frames;
+    }
+    if (!ReadRegisters(FIFO_R_W_, frames * fifo_frame_size_,
+                       data + frames_read * fifo_frame_size_,
+                       spi_data_settings_)) {
+      fifo_num_frames_ = frames_read;
+      RecordFault(FAULT_BUS);
+      return false;
+    }
+    frames_read += frames;
+  }
+  fifo_num_frames_ = num_frames;
+  consecutive_faults_ = 0;
+  if ((auto_recover_) && (++spot_check_reads_ >= SPOT_CHECK_READS_)) {
+    SpotCheck();
+  }
+  return true;
+}
+bool Mpu9250::UnpackFifo(const uint8_t * const data, const size_t frame) {
+  if (!UnpackFifoRaw(data, frame)) {
+    return false;
+  }
+  Convert();
+  return true;
+}
+bool Mpu9250::UnpackFifoRaw(const uint8_t * const data, const size_t frame) {
+  if ((!data) || (frame >= fifo_num_frames_)) {
+    return false;
+  }
+  const uint8_t *frame_buff = data + frame * fifo_frame_size_;
+  if (fifo_en_ & FIFO_ACCEL_EN_) {
+    accel_cnts_[1] = static_cast<int16_t>(frame_buff[0]) << 8 | frame_buff[1];
+    accel_cnts_[0] = static_cast<int16_t>(frame_buff[2]) << 8 | frame_buff[3];
+    accel_cnts_[2] = Negate(static_cast<int16_t>(frame_buff[4]) << 8 |
+                            frame_buff[5]);
+    frame_buff += 6;
+  }
+  if (fifo_en_ & FIFO_TEMP_EN_) {
+    temp_cnts_ =     static_cast<int16_t>(frame_buff[0]) << 8 | frame_buff[1];
+    frame_buff += 2;
+  }
+  if (fifo_en_ & FIFO_GYRO_EN_) {
+    gyro_cnts_[1] =  static_cast<int16_t>(frame_buff[0]) << 8 | frame_buff[1];
+    gyro_cnts_[0] =  static_cast<int16_t>(frame_buff[2]) << 8 | frame_buff[3];
+    gyro_cnts_[2] =  Negate(static_cast<int16_t>(frame_buff[4]) << 8 |
+                            frame_buff[5]);
+    frame_buff += 6;
+  }
+  new_mag_data_ = false;
+  if (fifo_en_ & FIFO_SLV0_EN_) {
+    new_mag_data_ = (frame_buff[0] & AK8963_DRDY_);
+    mag_cnts_[0] =   static_cast<int16_t>(frame_buff[2]) << 8 | frame_buff[1];
+    mag_cnts_[1] =   static_cast<int16_t>(frame_buff[4]) << 8 | frame_buff[3];
+    mag_cnts_[2] =   static_cast<int16_t>(frame_buff[6]) << 8 | frame_buff[5];
+  }
+  time_us_ = fifo_time_us_ + static_cast<uint32_t>(
+    static_cast<uint64_t>(frame) * SamplePeriodNs() / 1000);
+  return true;
+}
+void Mpu9250::Convert() {
+  /*
+  * The counts are already rotated and the scale factors, unit conversions,
+  * and calibration are folded together when the configuration changes
+  */
+  ApplyFold(accel_fold_, accel_cnts_, accel_mps2_);
+  ApplyFold(gyro_fold_, gyro_cnts_, gyro_radps_);
+  /* Stale magnetometer samples are not converted again */
+  if ((new_mag_data_) || (!mag_read_on_drdy_)) {
+    ApplyFold(mag_fold_, mag_cnts_, mag_ut_);
+  }
+  die_temperature_c_ = static_cast<float>(temp_cnts_) * TEMP_SCALE_ +
+                       TEMP_OFFSET_;
+  /* The interpolation segment is only recomputed when it is left */
+  if (tc_len_) {
+    if ((die_temperature_c_ < tc_lo_c_) || (die_temperature_c_ >= tc_hi_c_)) {
+      UpdateTempComp(die_temperature_c_);
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+      accel_mps2_[i] -= tc_accel_b_[i] + tc_accel_m_[i] * die_temperature_c_;
+      gyro_radps_[i] -= tc_gyro_b_[i] + tc_gyro_m_[i] * die_temperature_c_;
+    }
+  }
+  if (ring_) {
+    Sample sample;
+    sample.time_us = time_us_;
+    for (uint8_t i = 0; i < 3; i++) {
+      sample.accel_mps2[i] = accel_mps2_[i];
+      sample.gyro_radps[i] = gyro_radps_[i];
+      sample.mag_ut[i] = mag_ut_[i];
+    }
+    sample.die_temperature_c = die_temperature_c_;
+    ring_->Push(sample);
+  }
+}
+void Mpu9250::ConfigAccelCal(const float bias_mps2[3],
+                             const float scale[3][3]) {
+  for (uint8_t i = 0; i < 3; i++) {
+    accel_bias_mps2_[i] = bias_mps2[i];
+    for (uint8_t j = 0; j < 3; j++) {
+      accel_sm_[i][j] = scale[i][j];
+    }
+  }
+  FoldAccel();
+}
+void Mpu9250::accel_cal(float bias_mps2[3], float scale[3][3]) const {
+  for (uint8_t i = 0; i < 3; i++) {
+    bias_mps2[i] = accel_bias_mps2_[i];
+    for (uint8_t j = 0; j < 3; j++) {
+      scale[i][j] = accel_sm_[i][j];
+    }
+  }
+}
+void Mpu9250::ConfigGyroCal(const float bias_radps[3],
+                            const float scale[3][3]) {
+  for (uint8_t i = 0; i < 3; i++) {
+    gyro_bias_radps_[i] = bias_radps[i];
+    for (uint8_t j = 0; j < 3; j++) {
+      gyro_sm_[i][j] = scale[i][j];
+    }
+  }
+  FoldGyro();
+}
+void Mpu9250::gyro_cal(float bias_radps[3], float scale[3][3]) const {
+  for (uint8_t i = 0; i < 3; i++) {
+    bias_radps[i] = gyro_bias_radps_[i];
+    for (uint8_t j = 0; j < 3; j++) {
+      scale[i][j] = gyro_sm_[i][j];
+    }
+  }
+}
+void Mpu9250::ConfigMagCal(const float bias_ut[3], const float scale[3][3]) {
+  for (uint8_t i = 0; i < 3; i++) {
+    mag_bias_ut_[i] = bias_ut[i];
+    for (uint8_t j = 0; j < 3; j++) {
+      mag_sm_[i][j] = scale[i][j];
+    }
+  }
+  FoldMag();
+}
+void Mpu9250::mag_cal(float bias_ut[3], float scale[3][3]) const {
+  for (uint8_t i = 0; i < 3; i++) {
+    bias_ut[i] = mag_bias_ut_[i];
+    for (uint8_t j = 0; j < 3; j++) {
+      scale[i][j] = mag_sm_[i][j];
+    }
+  }
+}
+bool Mpu9250::ConfigTempComp(const TempCompPoint * const table,
+                             const uint8_t len) {
+  /* A null table or zero length disables compensation */
+  if ((!table) || (!len)) {
+    tc_table_ = nullptr;
+    tc_len_ = 0;
+    return true;
+  }
+  /* Temperatures must be strictly increasing */
+  for (uint8_t i = 1; i < len; i++) {
+    if (table[i].temp_c <= table[i - 1].temp_c) {
+      return false;
+    }
+  }
+  tc_table_ = table;
+  tc_len_ = len;
+  /* Force the segment to be computed on the next conversion */
+  tc_lo_c_ = 0.0f;
+  tc_hi_c_ = 0.0f;
+  return true;
+}
+void Mpu9250::UpdateTempComp(const float temp_c) {
+  static constexpr float TEMP_LIMIT_C = 1.0e6f;
+  const TempCompPoint &first = tc_table_[0];
+  const TempCompPoint &last = tc_table_[tc_len_ - 1];
+  /* Outside of the table the end point biases are held */
+  if ((temp_c < first.temp_c) || (temp_c >= last.temp_c)) {
+    const TempCompPoint &end = (temp_c < first.temp_c) ? first : last;
+    tc_lo_c_ = (temp_c < first.temp_c) ? -TEMP_LIMIT_C : last.temp_c;
+    tc_hi_c_ = (temp_c < first.temp_c) ? first.temp_c : TEMP_LIMIT_C;
+    for (uint8_t i = 0; i < 3; i++) {
+      tc_accel_b_[i] = end.accel_bias_mps2[i];
+      tc_accel_m_[i] = 0.0f;
+      tc_gyro_b_[i] = end.gyro_bias_radps[i];
+      tc_gyro_m_[i] = 0.0f;
+    }
+    return;
+  }
+  uint8_t seg = 0;
+  while (temp_c >= tc_table_[seg + 1].temp_c) {
+    seg++;
+  }
+  const TempCompPoint &lo = tc_table_[seg];
+  const TempCompPoint &hi = tc_table_[seg + 1];
+  tc_lo_c_ = lo.temp_c;
+  tc_hi_c_ = hi.temp_c;
+  /* bias = b + m * temp, so each read is one multiply-add per axis */
+  const float inv_dt = 1.0f / (hi.temp_c - lo.temp_c);
+  for (uint8_t i = 0; i < 3; i++) {
+    tc_accel_m_[i] = (hi.accel_bias_mps2[i] - lo.accel_bias_mps2[i]) * inv_dt;
+    tc_accel_b_[i] = lo.accel_bias_mps2[i] - tc_accel_m_[i] * lo.temp_c;
+    tc_gyro_m_[i] = (hi.gyro_bias_radps[i] - lo.gyro_bias_radps[i]) * inv_dt;
+    tc_gyro_b_[i] = lo.gyro_bias_radps[i] - tc_gyro_m_[i] * lo.temp_c;
+  }
+}
+void Mpu9250::FoldAccel() {
+  const float scale = accel_scale_ * G_MPS2_;
+  const float axis_scale[3] = {scale, scale, scale};
+  ComputeFold(axis_scale, accel_bias_mps2_, accel_sm_, &accel_fold_);
+}
+void Mpu9250::FoldGyro() {
+  const float scale = gyro_scale_ * DEG2RAD_;
+  const float axis_scale[3] = {scale, scale, scale};
+  ComputeFold(axis_scale, gyro_bias_radps_, gyro_sm_, &gyro_fold_);
+}
+void Mpu9250::FoldMag() {
+  ComputeFold(mag_scale_, mag_bias_ut_, mag_sm_, &mag_fold_);
+}
+void Mpu9250::ComputeFold(const float axis_scale[3], const float bias[3],
+                          const float sm[3][3], Fold * const fold) {
+  /* output = sm * (axis_scale * counts - bias) */
+  fold->diag = true;
+  for (uint8_t i = 0; i < 3; i++) {
+    fold->bias[i] = 0.0f;
+    for (uint8_t j = 0; j < 3; j++) {
+      fold->scale[i][j] = sm[i][j] * axis_scale[j];
+      fold->bias[i] -= sm[i][j] * bias[j];
+      if ((i != j) && (sm[i][j] != 0.0f)) {
+        fold->diag = false;
+      }
+    }
+  }
+}
+void Mpu9250::ApplyFold(const Fold &fold, const int16_t cnts[3],
+                        float out[3]) {
+  const float x = static_cast<float>(cnts[0]);
+  const float y = static_cast<float>(cnts[1]);
+  const float z = static_cast<float>(cnts[2]);
+  /* One multiply-add per axis unless there is cross axis calibration */
+  if (fold.diag) {
+    out[0] = fold.scale[0][0] * x + fold.bias[0];
+    out[1] = fold.scale[1][1] * y + fold.bias[1];
+    out[2] = fold.scale[2][2] * z + fold.bias[2];
+  } else {
+    out[0] = fold.scale[0][0] * x + fold.scale[0][1] * y +
+             fold.scale[0][2] * z + fold.bias[0];
+    out[1] = fold.scale[1][0] * x + fold.scale[1][1] * y +
+             fold.scale[1][2] * z + fold.bias[1];
+    out[2] = fold.scale[2][0] * x + fold.scale[2][1] * y +
+             fold.scale[2][2] * z + fold.bias[2];
+  }
+}
+bool Mpu9250::ReadHwOffsets() {
+  /* XG, YG and ZG offsets are contiguous, XA, YA and ZA are 3 apart */
+  uint8_t gyro_buff[6];
+  if (!ReadRegisters(XG_OFFSET_H_, sizeof(gyro_buff), gyro_buff)) {
+    return false;
+  }
+  uint8_t accel_buff[8];
+  if (!ReadRegisters(XA_OFFSET_H_, sizeof(accel_buff), accel_buff)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    hw_offsets_.gyro[i] = static_cast<int16_t>(gyro_buff[2 * i]) << 8 |
+                          gyro_buff[2 * i + 1];
+    /* Arithmetic shift keeps the sign of the 15 bit offset */
+    hw_offsets_.accel[i] = static_cast<int16_t>(
+      static_cast<int16_t>(accel_buff[3 * i]) << 8 | accel_buff[3 * i + 1])
+      >> 1;
+  }
+  return true;
+}
+int32_t Mpu9250::Round(const float val) {
+  return static_cast<int32_t>((val >= 0.0f) ? val + 0.5f : val - 0.5f);
+}
+int16_t Mpu9250::Clamp(const int32_t val, const int16_t min,
+                       const int16_t max) {
+  if (val < min) {
+    return min;
+  }
+  if (val > max) {
+    return max;
+  }
+  return static_cast<int16_t>(val);
+}
+float Mpu9250::AccelScale(const AccelRange range) {
+  switch (range) {
+    case ACCEL_RANGE_2G: {
+      return 2.0f / 32767.5f;
+    }
+    case ACCEL_RANGE_4G: {
+      return 4.0f / 32767.5f;
+    }
+    case ACCEL_RANGE_8G: {
+      return 8.0f / 32767.5f;
+    }
+    case ACCEL_RANGE_16G: {
+      return 16.0f / 32767.5f;
+    }
+    default: {
+      return 0.0f;
+    }
+  }
+}
+float Mpu9250::GyroScale(const GyroRange range) {
+  switch (range) {
+    case GYRO_RANGE_250DPS: {
+      return 250.0f / 32767.5f;
+    }
+    case GYRO_RANGE_500DPS: {
+      return 500.0f / 32767.5f;
+    }
+    case GYRO_RANGE_1000DPS: {
+      return 1000.0f / 32767.5f;
+    }
+    case GYRO_RANGE_2000DPS: {
+      return 2000.0f / 32767.5f;
+    }
+    default: {
+      return 0.0f;
+    }
+  }
+}
+bool Mpu9250::ValidGyroBandwidth(const GyroBandwidth bandwidth) {
+  switch (bandwidth) {
+    case GYRO_BANDWIDTH_8800HZ:
+    case GYRO_BANDWIDTH_3600HZ:
+    case GYRO_BANDWIDTH_250HZ:
+    case GYRO_BANDWIDTH_184HZ:
+    case GYRO_BANDWIDTH_92HZ:
+    case GYRO_BANDWIDTH_41HZ:
+    case GYRO_BANDWIDTH_20HZ:
+    case GYRO_BANDWIDTH_10HZ:
+    case GYRO_BANDWIDTH_5HZ: {
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+bool Mpu9250::ValidAccelBandwidth(const AccelBandwidth bandwidth) {
+  switch (bandwidth) {
+    case ACCEL_BANDWIDTH_1130HZ:
+    case ACCEL_BANDWIDTH_420HZ:
+    case ACCEL_BANDWIDTH_218HZ:
+    case ACCEL_BANDWIDTH_99HZ:
+    case ACCEL_BANDWIDTH_45HZ:
+    case ACCEL_BANDWIDTH_21HZ:
+    case ACCEL_BANDWIDTH_10HZ:
+    case ACCEL_BANDWIDTH_5HZ: {
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+bool Mpu9250::WriteImuConfig(const AccelRange accel_range,
+                             const GyroRange gyro_range,
+                             const GyroBandwidth gyro_bandwidth,
+                             const AccelBandwidth accel_bandwidth,
+                             const uint8_t srd) {
+  /* Check inputs are valid */
+  float accel_scale = AccelScale(accel_range);
+  float gyro_scale = GyroScale(gyro_range);
+  if ((accel_scale == 0.0f) || (gyro_scale == 0.0f)) {
+    return false;
+  }
+  if ((!ValidGyroBandwidth(gyro_bandwidth)) ||
+      (!ValidAccelBandwidth(accel_bandwidth))) {
+    return false;
+  }
+  /* SMPLRT_DIV, CONFIG, GYRO_CONFIG, ACCEL_CONFIG, ACCEL_CONFIG2 */
+  uint8_t config[] = {
+    srd,
+    static_cast<uint8_t>(gyro_bandwidth & DLPF_CFG_MASK_),
+    static_cast<uint8_t>(gyro_range | (gyro_bandwidth >> 3)),
+    accel_range,
+    accel_bandwidth
+  };
+  if (!WriteRegisters(SMPLRT_DIV_, sizeof(config), config)) {
+    return false;
+  }
+  /* Update stored configuration and scales */
+  smplrt_div_ = srd;
+  srd_ = srd;
+  gyro_bandwidth_ = gyro_bandwidth;
+  accel_bandwidth_ = accel_bandwidth;
+  accel_range_ = accel_range;
+  accel_scale_ = accel_scale;
+  FoldAccel();
+  gyro_range_ = gyro_range;
+  gyro_scale_ = gyro_scale;
+  FoldGyro();
+  return true;
+}
+void Mpu9250::ConfigI2cBusClear(const uint8_t scl_pin,
+                                const uint8_t sda_pin) {
+  i2c_scl_pin_ = scl_pin;
+  i2c_sda_pin_ = sda_pin;
+}
+bool Mpu9250::Recover() {
+  recoveries_++;
+  consecutive_faults_ = 0;
+  frozen_reads_ = 0;
+  /* Release a slave holding SDA low, then restart the bus */
+  if ((iface_ == I2C) && (i2c_scl_pin_ != NO_PIN_) &&
+      (i2c_sda_pin_ != NO_PIN_)) {
+    ClearI2cBus();
+  }
+  BeginBus();
+  /* The WHO AM I spot check shows whether the sensor responds at all */
+  uint8_t who_am_i;
+  if ((!ReadRegisters(WHOAMI_, sizeof(who_am_i), &who_am_i)) ||
+      ((who_am_i != WHOAMI_MPU9250_) && (who_am_i != WHOAMI_MPU9255_))) {
+    fault_ = FAULT_WHOAMI;
+    return false;
+  }
+  /* A configuration that survived only needs the I2C master and FIFO reset */
+  bool intact;
+  if (!CheckConfig(&intact)) {
+    return false;
+  }
+  if (intact) {
+    uint8_t user_ctrl = I2C_MST_EN_ | I2C_MST_RST_;
+    if (fifo_en_) {
+      user_ctrl |= USER_FIFO_EN_ | FIFO_RST_;
+    }
+    /* I2C_MST_RST and FIFO_RST self clear so they can't be verified */
+    if (!WriteRegister(USER_CTRL_, user_ctrl, WRITE_VERIFY_NONE)) {
+      return false;
+    }
+    fifo_num_frames_ = 0;
+    fault_ = FAULT_NONE;
+    return true;
+  }
+  /* The sensor was reset, restore the cached configuration */
+  const uint8_t fifo_en = fifo_en_;
+  const bool wom_en = wom_en_;
+  const HwOffsets offsets = hw_offsets_;
+  if (!Begin(profile())) {
+    return false;
+  }
+  if (!ConfigHwOffsets(offsets)) {
+    return false;
+  }
+  if (!WriteRegister(INT_PIN_CFG_, drdy_latch_ ? INT_LATCH_ANYRD_CLEAR_ :
+                     INT_PULSE_50US_)) {
+    return false;
+  }
+  if (!WriteRegister(INT_ENABLE_, drdy_int_en_ ? INT_RAW_RDY_EN_ :
+                     INT_DISABLE_)) {
+    return false;
+  }
+  if (fifo_en) {
+    if (!EnableFifo(fifo_en & FIFO_ACCEL_EN_, fifo_en & FIFO_GYRO_EN_,
+                    fifo_en & FIFO_SLV0_EN_, fifo_en & FIFO_TEMP_EN_)) {
+      return false;
+    }
+  }
+  /* Begin leaves wake on motion off, re-enter it with the cached settings */
+  if (wom_en) {
+    if (!EnableWom(wom_threshold_mg_, wom_odr_)) {
+      return false;
+    }
+  }
+  fault_ = FAULT_NONE;
+  return true;
+}
+bool Mpu9250::CheckConfig(bool * const intact) {
+  uint8_t pwr_mgmnt_1;
+  if (!ReadRegisters(PWR_MGMNT_1_, sizeof(pwr_mgmnt_1), &pwr_mgmnt_1)) {
+    return false;
+  }
+  /* Wake on motion changes the accel configuration, so it isn't compared */
+  if (wom_en_) {
+    *intact = (pwr_mgmnt_1 == (PWR_CYCLE_ | CLKSEL_PLL_));
+    return true;
+  }
+  /* A reset returns SMPLRT_DIV through ACCEL_CONFIG2 to their defaults */
+  uint8_t config[5];
+  const uint8_t expected[5] = {
+    srd_,
+    static_cast<uint8_t>(gyro_bandwidth_ & DLPF_CFG_MASK_),
+    static_cast<uint8_t>(gyro_range_ | (gyro_bandwidth_ >> 3)),
+    accel_range_,
+    accel_bandwidth_
+  };
+  if (!ReadRegisters(SMPLRT_DIV_, sizeof(config), config)) {
+    return false;
+  }
+  *intact = (pwr_mgmnt_1 == CLKSEL_PLL_) &&
+            (!memcmp(config, expected, sizeof(config)));
+  return true;
+}
+void Mpu9250::SpotCheck() {
+  spot_check_reads_ = 0;
+  uint8_t who_am_i;
+  if ((!ReadRegisters(WHOAMI_, sizeof(who_am_i), &who_am_i)) ||
+      ((who_am_i != WHOAMI_MPU9250_) && (who_am_i != WHOAMI_MPU9255_))) {
+    RecordFault(FAULT_WHOAMI);
+    return;
+  }
+  bool intact;
+  if (!CheckConfig(&intact)) {
+    RecordFault(FAULT_BUS);
+    return;
+  }
+  if (!intact) {
+    RecordFault(FAULT_CONFIG);
+  }
+}
+void Mpu9250::ClearI2cBus() {
+  /* Clock out a slave holding SDA low mid byte */
+  i2c_->end();
+  pinMode(i2c_sda_pin_, INPUT_PULLUP);
+  pinMode(i2c_scl_pin_, INPUT_PULLUP);
+  for (uint8_t i = 0; i < I2C_CLEAR_PULSES_; i++) {
+    if (digitalRead(i2c_sda_pin_) == HIGH) {
+      break;
+    }
+    digitalWrite(i2c_scl_pin_, LOW);
+    pinMode(i2c_scl_pin_, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(i2c_scl_pin_, INPUT_PULLUP);
+    delayMicroseconds(5);
+  }
+  /* Start and stop conditions reset the slave state machines */
+  digitalWrite(i2c_sda_pin_, LOW);
+  pinMode(i2c_sda_pin_, OUTPUT);
+  delayMicroseconds(5);
+  pinMode(i2c_sda_pin_, INPUT_PULLUP);
+  delayMicroseconds(5);
+}
+bool Mpu9250::CheckData(const uint8_t * const data_buff) {
+  /* Wake on motion duty cycles the accel and turns off the gyro */
+  if (wom_en_) {
+    return true;
+  }
+  const uint8_t *imu_data = data_buff + 1;
+  const uint8_t *accel = imu_data;
+  const uint8_t *gyro = imu_data + 8;
+  bool data_ready = (data_buff[0] & RAW_DATA_RDY_INT_);
+  uint32_t now_us = micros();
+  if (!data_ready) {
+    /* No new sample for several sample periods, the sensor has stalled */
+    uint32_t stall_us = STALL_PERIODS_ * (SamplePeriodNs() / 1000);
+    if (now_us - last_sample_us_ > stall_us) {
+      last_sample_us_ = now_us;
+      RecordFault(FAULT_FROZEN);
+    }
+    return true;
+  }
+  /* A floating or shorted data line reads all 0xFF or all 0x00 */
+  bool all_ff = true, all_00 = true;
+  for (uint8_t i = 0; i < IMU_DATA_LEN_ - 2; i++) {
+    all_ff = all_ff && (imu_data[i] == 0xFF);
+    all_00 = all_00 && (imu_data[i] == 0x00);
+  }
+  if ((all_ff) || (all_00)) {
+    RecordFault(FAULT_DATA);
+    return false;
+  }
+  /* Noise changes the counts of a live sensor on every sample */
+  bool frozen =
+    (accel_cnts_[1] == static_cast<int16_t>(accel[0] << 8 | accel[1])) &&
+    (accel_cnts_[0] == static_cast<int16_t>(accel[2] << 8 | accel[3])) &&
+    (gyro_cnts_[1] == static_cast<int16_t>(gyro[0] << 8 | gyro[1])) &&
+    (gyro_cnts_[0] == static_cast<int16_t>(gyro[2] << 8 | gyro[3]));
+  if (frozen) {
+    if (++frozen_reads_ >= FROZEN_LIMIT_) {
+      frozen_reads_ = 0;
+      RecordFault(FAULT_FROZEN);
+      return false;
+    }
+  } else {
+    frozen_reads_ = 0;
+  }
+  last_sample_us_ = now_us;
+  consecutive_faults_ = 0;
+  return true;
+}
+void Mpu9250::RecordFault(const Fault fault) {
+  fault_ = fault;
+  /* Bus errors and garbage frames may be transient, the others persist */
+  bool transient = (fault == FAULT_BUS) || (fault == FAULT_DATA);
+  if ((++consecutive_faults_ >= FAULT_LIMIT_) || (!transient)) {
+    if (auto_recover_) {
+      #if defined(SPI_HAS_TRANSFER_ASYNC)
+      /* Recovery can't use the bus while an asynchronous read has it */
+      if (async_busy_) {
+        recover_pending_ = true;
+      } else {
+        Recover();
+      }
+      #else
+      Recover();
+      #endif
+    }
+    consecutive_faults_ = 0;
+  }
+}
+void Mpu9250::BeginBus() {
+  if (iface_ == I2C) {
+    i2c_->begin();
+    i2c_->setClock(i2c_clock_);
+  } else if (iface_ == BUS) {
+    bus_->Begin();
+  } else {
+    pinMode(conn_, OUTPUT);
+    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+        defined(__IMXRT1052__)
+    digitalWriteFast(conn_, HIGH);
+    #else
+    digitalWrite(conn_, HIGH);
+    #endif
+    spi_->begin();
+  }
+}
+bool Mpu9250::WriteRegister(uint8_t reg, uint8_t data) {
+  return WriteRegister(reg, data, write_verify_);
+}
+bool Mpu9250::WriteRegister(uint8_t reg, uint8_t data,
+                            const WriteVerify verify) {
+  uint8_t ret_val;
+  uint8_t attempts = (verify == WRITE_VERIFY_RETRY) ? WRITE_ATTEMPTS_ : 1;
+  for (uint8_t i = 0; i < attempts; i++) {
+    bool ack = true;
+    if (iface_ == I2C) {
+      i2c_->beginTransmission(conn_);
+      i2c_->write(reg);
+      i2c_->write(data);
+      ack = (i2c_->endTransmission() == 0);
+      #if defined(MPU9250_STATS)
+      if (!ack) {
+        stats_.bus_errors++;
+      }
+      #endif
+    } else if (iface_ == BUS) {
+      ack = bus_->WriteRegisters(reg, sizeof(data), &data);
+    } else {
+      if (!BeginSpiAccess()) {
+        return false;
+      }
+      spi_->beginTransaction(spi_reg_settings_);
+      #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+          defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+          defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+          defined(__IMXRT1052__)
+      digitalWriteFast(conn_, LOW);
+      #else
+      digitalWrite(conn_, LOW);
+      #endif
+      #if defined(__IMXRT1062__)
+        delayNanoseconds(200);
+      #endif
+      spi_->transfer(reg);
+      spi_->transfer(data);
+      #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+          defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+          defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+          defined(__IMXRT1052__)
+      digitalWriteFast(conn_, HIGH);
+      #else
+      digitalWrite(conn_, HIGH);
+      #endif
+      #if defined(__IMXRT1062__)
+        delayNanoseconds(200);
+      #endif
+      spi_->endTransaction();
+      EndSpiAccess();
+    }
+    /* Registers take effect immediately, no settling time is needed */
+    if (verify == WRITE_VERIFY_NONE) {
+      return ack;
+    }
+    if ((ReadRegisters(reg, sizeof(ret_val), &ret_val)) && (data == ret_val)) {
+      return true;
+    }
+  }
+  return false;
+}
+bool Mpu9250::WriteRegisters(uint8_t reg, uint8_t count,
+                             const uint8_t * const data) {
+  /* Consecutive registers are written with one burst and verified with one */
+  uint8_t ret_val[MAX_WRITE_BURST_];
+  if (count > MAX_WRITE_BURST_) {
+    return false;
+  }
+  uint8_t attempts = (write_verify_ == WRITE_VERIFY_RETRY) ?
+                     WRITE_ATTEMPTS_ : 1;
+  for (uint8_t i = 0; i < attempts; i++) {
+    bool ack = true;
+    if (iface_ == I2C) {
+      i2c_->beginTransmission(conn_);
+      i2c_->write(reg);
+      i2c_->write(data, count);
+      ack = (i2c_->endTransmission() == 0);
+      #if defined(MPU9250_STATS)
+      if (!ack) {
+        stats_.bus_errors++;
+      }
+      #endif
+    } else if (iface_ == BUS) {
+      ack = bus_->WriteRegisters(reg, count, data);
+    } else {
+      if (!BeginSpiAccess()) {
+        return false;
+      }
+      spi_->beginTransaction(spi_reg_settings_);
+      #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+          defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+          defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+          defined(__IMXRT1052__)
+      digitalWriteFast(conn_, LOW);
+      #else
+      digitalWrite(conn_, LOW);
+      #endif
+      #if defined(__IMXRT1062__)
+        delayNanoseconds(200);
+      #endif
+      spi_->transfer(reg);
+      for (uint8_t j = 0; j < count; j++) {
+        spi_->transfer(data[j]);
+      }
+      #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+          defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+          defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+          defined(__IMXRT1052__)
+      digitalWriteFast(conn_, HIGH);
+      #else
+      digitalWrite(conn_, HIGH);
+      #endif
+      #if defined(__IMXRT1062__)
+        delayNanoseconds(200);
+      #endif
+      spi_->endTransaction();
+      EndSpiAccess();
+    }
+    if (write_verify_ == WRITE_VERIFY_NONE) {
+      return ack;
+    }
+    if ((ReadRegisters(reg, count, ret_val)) &&
+        (memcmp(data, ret_val, count) == 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+bool Mpu9250::ReadRegisters(uint8_t reg, uint8_t count, uint8_t *data) {
+  return ReadRegisters(reg, count, data, spi_reg_settings_);
+}
+bool Mpu9250::ReadRegisters(uint8_t reg, uint8_t count, uint8_t *data,
+                            const SPISettings &settings) {
+  if (iface_ == I2C) {
+    /* Repeated start, the bus is held between the address and data phase */
+    i2c_->beginTransmission(conn_);
+    i2c_->write(reg);
+    if (i2c_->endTransmission(false) != 0) {
+      #if defined(MPU9250_STATS)
+      stats_.bus_errors++;
+      #endif
+      return false;
+    }
+    uint8_t bytes_rx = i2c_->requestFrom(conn_, count);
+    if (bytes_rx == count) {
+      for (int i = 0; i < count; i++) {
+        data[i] = i2c_->read();
+      }
+      return true;
+    } else {
+      #if defined(MPU9250_STATS)
+      stats_.bus_errors++;
+      #endif
+      return false;
+    }
+  } else if (iface_ == BUS) {
+    /* Custom buses select their own clocks */
+    return bus_->ReadRegisters(reg, count, data);
+  } else {
+    if (!BeginSpiAccess()) {
+      return false;
+    }
+    spi_->beginTransaction(settings);
+    SpiReadRegisters(reg, count, data);
+    spi_->endTransaction();
+    EndSpiAccess();
+    return true;
+  }
+}
+void Mpu9250::SpiReadRegisters(uint8_t reg, uint8_t count, uint8_t *data) {
+  #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+      defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+      defined(__IMXRT1052__)
+  digitalWriteFast(conn_, LOW);
+  #else
+  digitalWrite(conn_, LOW);
+  #endif
+  #if defined(__IMXRT1062__)
+    delayNanoseconds(200);
+  #endif
+  spi_->transfer(reg | SPI_READ_);
+  spi_->transfer(data, count);
+  #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+      defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+      defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+      defined(__IMXRT1052__)
+  digitalWriteFast(conn_, HIGH);
+  #else
+  digitalWrite(conn_, HIGH);
+  #endif
+  #if defined(__IMXRT1062__)
+    delayNanoseconds(200);
+  #endif
+}
+bool Mpu9250::WriteAk8963Register(uint8_t reg, uint8_t data) {
+  return Mpu9250Core<Mpu9250>::WriteAk8963Register(this, reg, data);
+}
+bool Mpu9250::WriteAk8963Register(uint8_t reg, uint8_t data,
+                                  const WriteVerify verify) {
+  return Mpu9250Core<Mpu9250>::WriteAk8963Register(this, reg, data, verify);
+}
+bool Mpu9250::ReadAk8963Registers(uint8_t reg, uint8_t count, uint8_t *data) {
+  return Mpu9250Core<Mpu9250>::ReadAk8963Registers(this, reg, count, data);
+}
+bool Mpu9250::ConfigAk8963Mode(const uint8_t mode) {
+  return Mpu9250Core<Mpu9250>::ConfigAk8963Mode(this, mode);
 }
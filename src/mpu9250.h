@@ -30,6 +30,15 @@
 #include "Wire.h"
 #include "SPI.h"
 
+/*
+* Define MPU9250_STATS, i.e. in the build flags or by uncommenting below, to
+* collect driver statistics in each Mpu9250 object
+*/
+// #define MPU9250_STATS
+
+class Mpu9250Ring;
+class Mpu9250Bus;
+
 class Mpu9250 {
  public:
   enum DlpfBandwidth : uint8_t {
@@ -40,6 +49,27 @@ class Mpu9250 {
     DLPF_BANDWIDTH_10HZ = 0x05,
     DLPF_BANDWIDTH_5HZ = 0x06
   };
+  enum GyroBandwidth : uint8_t {
+    GYRO_BANDWIDTH_8800HZ = 0x08,
+    GYRO_BANDWIDTH_3600HZ = 0x10,
+    GYRO_BANDWIDTH_250HZ = 0x00,
+    GYRO_BANDWIDTH_184HZ = 0x01,
+    GYRO_BANDWIDTH_92HZ = 0x02,
+    GYRO_BANDWIDTH_41HZ = 0x03,
+    GYRO_BANDWIDTH_20HZ = 0x04,
+    GYRO_BANDWIDTH_10HZ = 0x05,
+    GYRO_BANDWIDTH_5HZ = 0x06
+  };
+  enum AccelBandwidth : uint8_t {
+    ACCEL_BANDWIDTH_1130HZ = 0x08,
+    ACCEL_BANDWIDTH_420HZ = 0x07,
+    ACCEL_BANDWIDTH_218HZ = 0x01,
+    ACCEL_BANDWIDTH_99HZ = 0x02,
+    ACCEL_BANDWIDTH_45HZ = 0x03,
+    ACCEL_BANDWIDTH_21HZ = 0x04,
+    ACCEL_BANDWIDTH_10HZ = 0x05,
+    ACCEL_BANDWIDTH_5HZ = 0x06
+  };
   enum AccelRange : uint8_t {
     ACCEL_RANGE_2G = 0x00,
     ACCEL_RANGE_4G = 0x08,
@@ -52,11 +82,112 @@ class Mpu9250 {
     GYRO_RANGE_1000DPS = 0x10,
     GYRO_RANGE_2000DPS = 0x18
   };
+  enum LpAccelOdr : uint8_t {
+    LP_ACCEL_ODR_0_24HZ = 0,
+    LP_ACCEL_ODR_0_49HZ = 1,
+    LP_ACCEL_ODR_0_98HZ = 2,
+    LP_ACCEL_ODR_1_95HZ = 3,
+    LP_ACCEL_ODR_3_91HZ = 4,
+    LP_ACCEL_ODR_7_81HZ = 5,
+    LP_ACCEL_ODR_15_63HZ = 6,
+    LP_ACCEL_ODR_31_25HZ = 7,
+    LP_ACCEL_ODR_62_50HZ = 8,
+    LP_ACCEL_ODR_125HZ = 9,
+    LP_ACCEL_ODR_250HZ = 10,
+    LP_ACCEL_ODR_500HZ = 11
+  };
+  enum AuxI2cClock : uint8_t {
+    AUX_I2C_CLOCK_348KHZ = 0,
+    AUX_I2C_CLOCK_333KHZ = 1,
+    AUX_I2C_CLOCK_320KHZ = 2,
+    AUX_I2C_CLOCK_308KHZ = 3,
+    AUX_I2C_CLOCK_296KHZ = 4,
+    AUX_I2C_CLOCK_286KHZ = 5,
+    AUX_I2C_CLOCK_276KHZ = 6,
+    AUX_I2C_CLOCK_267KHZ = 7,
+    AUX_I2C_CLOCK_258KHZ = 8,
+    AUX_I2C_CLOCK_500KHZ = 9,
+    AUX_I2C_CLOCK_471KHZ = 10,
+    AUX_I2C_CLOCK_444KHZ = 11,
+    AUX_I2C_CLOCK_421KHZ = 12,
+    AUX_I2C_CLOCK_400KHZ = 13,
+    AUX_I2C_CLOCK_381KHZ = 14,
+    AUX_I2C_CLOCK_364KHZ = 15
+  };
+  enum Fault : uint8_t {
+    FAULT_NONE,
+    FAULT_BUS,
+    FAULT_DATA,
+    FAULT_FROZEN,
+    FAULT_WHOAMI,
+    FAULT_CONFIG
+  };
+  enum WriteVerify : uint8_t {
+    WRITE_VERIFY_NONE,
+    WRITE_VERIFY,
+    WRITE_VERIFY_RETRY
+  };
+  struct Sample {
+    uint32_t time_us;
+    float accel_mps2[3];
+    float gyro_radps[3];
+    float mag_ut[3];
+    float die_temperature_c;
+  };
+  struct Profile {
+    AccelRange accel_range;
+    GyroRange gyro_range;
+    DlpfBandwidth dlpf;
+    uint8_t srd;
+    float mag_scale[3];
+    GyroBandwidth gyro_bandwidth;
+    AccelBandwidth accel_bandwidth;
+  };
+  struct HwOffsets {
+    int16_t accel[3];
+    int16_t gyro[3];
+  };
+  struct SelfTestResult {
+    bool accel_pass[3];
+    bool gyro_pass[3];
+    bool mag_pass[3];
+    float accel_ratio[3];
+    float gyro_ratio[3];
+    float mag_cnts[3];
+  };
+  struct TempCompPoint {
+    float temp_c;
+    float accel_bias_mps2[3];
+    float gyro_bias_radps[3];
+  };
+  #if defined(MPU9250_STATS)
+  struct Stats {
+    uint32_t reads;
+    uint32_t no_data;
+    uint32_t bus_errors;
+    uint32_t fifo_overflows;
+    uint32_t missed_drdy;
+    uint32_t max_read_us;
+    uint32_t total_read_us;
+  };
+  #endif
   Mpu9250(TwoWire *bus, uint8_t addr);
   Mpu9250(SPIClass *bus, uint8_t cs);
+  explicit Mpu9250(Mpu9250Bus *bus);
+  void ConfigI2cClock(const uint32_t clock);
+  inline uint32_t i2c_clock() const {return i2c_clock_;}
+  void ConfigSpiClock(const uint32_t reg_clock, const uint32_t data_clock);
+  inline uint32_t spi_reg_clock() const {return spi_reg_clock_;}
+  inline uint32_t spi_data_clock() const {return spi_data_clock_;}
   bool Begin();
+  bool Begin(const Profile &profile);
+  Profile profile() const;
   bool EnableDrdyInt();
+  bool EnableDrdyInt(const bool latch);
   bool DisableDrdyInt();
+  bool EnableWom(const uint16_t threshold_mg, const LpAccelOdr odr);
+  bool DisableWom();
+  inline bool wom_enabled() const {return wom_en_;}
   bool ConfigAccelRange(const AccelRange range);
   inline AccelRange accel_range() const {return accel_range_;}
   bool ConfigGyroRange(const GyroRange range);
@@ -65,8 +196,61 @@ class Mpu9250 {
   inline uint8_t srd() const {return srd_;}
   bool ConfigDlpf(const DlpfBandwidth dlpf);
   inline DlpfBandwidth dlpf() const {return dlpf_bandwidth_;}
+  bool ConfigGyroBandwidth(const GyroBandwidth bandwidth);
+  inline GyroBandwidth gyro_bandwidth() const {return gyro_bandwidth_;}
+  bool ConfigAccelBandwidth(const AccelBandwidth bandwidth);
+  inline AccelBandwidth accel_bandwidth() const {return accel_bandwidth_;}
+  bool ConfigImu(const AccelRange accel_range, const GyroRange gyro_range,
+                 const DlpfBandwidth dlpf, const uint8_t srd);
+  bool ConfigAuxI2cClock(const AuxI2cClock clock);
+  inline AuxI2cClock aux_i2c_clock() const {return aux_i2c_clock_;}
+  void ConfigAccelCal(const float bias_mps2[3], const float scale[3][3]);
+  void accel_cal(float bias_mps2[3], float scale[3][3]) const;
+  void ConfigGyroCal(const float bias_radps[3], const float scale[3][3]);
+  void gyro_cal(float bias_radps[3], float scale[3][3]) const;
+  void ConfigMagCal(const float bias_ut[3], const float scale[3][3]);
+  void mag_cal(float bias_ut[3], float scale[3][3]) const;
+  bool ConfigTempComp(const TempCompPoint * const table, const uint8_t len);
+  inline uint8_t temp_comp_len() const {return tc_len_;}
+  inline void ConfigMagReadOnDrdy(const bool en) {mag_read_on_drdy_ = en;}
+  inline bool mag_read_on_drdy() const {return mag_read_on_drdy_;}
+  inline void AttachRing(Mpu9250Ring * const ring) {ring_ = ring;}
+  bool CalibrateHwOffsets();
+  bool SelfTest(SelfTestResult * const result);
+  bool ConfigHwOffsets(const HwOffsets &offsets);
+  inline HwOffsets hw_offsets() const {return hw_offsets_;}
+  void ConfigWriteVerify(const WriteVerify verify);
+  inline WriteVerify write_verify() const {return write_verify_;}
+  inline void ConfigAutoRecover(const bool en) {auto_recover_ = en;}
+  inline bool auto_recover() const {return auto_recover_;}
+  void ConfigI2cBusClear(const uint8_t scl_pin, const uint8_t sda_pin);
+  bool Recover();
+  inline Fault fault() const {return fault_;}
+  inline uint32_t recoveries() const {return recoveries_;}
   void DrdyCallback(uint8_t int_pin, void (*function)());
+  #if defined(MPU9250_STATS)
+  Stats stats() const;
+  void ResetStats();
+  #endif
   bool Read();
+  bool ReadRaw();
+  void Convert();
+  #if defined(SPI_HAS_TRANSFER_ASYNC)
+  bool ReadAsync();
+  bool AsyncReadComplete();
+  void AsyncReadCallback(void (*function)());
+  inline bool async_read_busy() const {return async_busy_;}
+  #endif
+  bool EnableFifo(const bool accel, const bool gyro, const bool mag,
+                  const bool temp);
+  bool DisableFifo();
+  bool ResetFifo();
+  bool ReadFifo(uint8_t * const data, const size_t len);
+  bool UnpackFifo(const uint8_t * const data, const size_t frame);
+  bool UnpackFifoRaw(const uint8_t * const data, const size_t frame);
+  inline uint8_t fifo_frame_size() const {return fifo_frame_size_;}
+  inline size_t fifo_num_frames() const {return fifo_num_frames_;}
+  inline bool fifo_overflow() const {return fifo_overflow_;}
   inline float accel_x_mps2() const {return accel_mps2_[0];}
   inline float accel_y_mps2() const {return accel_mps2_[1];}
   inline float accel_z_mps2() const {return accel_mps2_[2];}
@@ -77,42 +261,204 @@ class Mpu9250 {
   inline float mag_y_ut() const {return mag_ut_[1];}
   inline float mag_z_ut() const {return mag_ut_[2];}
   inline float die_temperature_c() const {return die_temperature_c_;}
+  inline uint32_t time_us() const {return time_us_;}
+  inline bool new_mag_data() const {return new_mag_data_;}
+  inline int16_t accel_x_cnts() const {return accel_cnts_[0];}
+  inline int16_t accel_y_cnts() const {return accel_cnts_[1];}
+  inline int16_t accel_z_cnts() const {return accel_cnts_[2];}
+  inline int16_t gyro_x_cnts() const {return gyro_cnts_[0];}
+  inline int16_t gyro_y_cnts() const {return gyro_cnts_[1];}
+  inline int16_t gyro_z_cnts() const {return gyro_cnts_[2];}
+  inline int16_t mag_x_cnts() const {return mag_cnts_[0];}
+  inline int16_t mag_y_cnts() const {return mag_cnts_[1];}
+  inline int16_t mag_z_cnts() const {return mag_cnts_[2];}
+  inline int16_t die_temperature_cnts() const {return temp_cnts_;}
 
  private:
+  friend class Mpu9250Group;
+  friend class Mpu9250Log;
+  friend class Mpu9250Decimator;
+  friend class Mpu9250MagCal;
+  template<typename Bus, AccelRange, GyroRange> friend class Mpu9250T;
+  template<typename Dev> friend class Mpu9250Core;
   enum Interface {
     SPI,
-    I2C
+    I2C,
+    BUS
   };
   /* Communications interface */
   Interface iface_;
   TwoWire *i2c_;
   SPIClass *spi_;
+  Mpu9250Bus *bus_;
   uint8_t conn_;
-  uint32_t spi_clock_;
-  static constexpr uint32_t I2C_CLOCK_ = 400000;
+  /* Register access is limited to 1 MHz, sensor data can be read at 20 MHz */
+  uint32_t spi_reg_clock_ = 1000000;
+  uint32_t spi_data_clock_ = 20000000;
+  SPISettings spi_reg_settings_ = SPISettings(1000000, MSBFIRST, SPI_MODE3);
+  SPISettings spi_data_settings_ = SPISettings(20000000, MSBFIRST, SPI_MODE3);
+  uint32_t i2c_clock_ = 400000;
   static constexpr uint8_t SPI_READ_ = 0x80;
+  static constexpr size_t SPI_MAX_BURST_ = 255;
+  static constexpr size_t I2C_MAX_BURST_ = 32;
   /* Configuration */
   AccelRange accel_range_;
   GyroRange gyro_range_;
   DlpfBandwidth dlpf_bandwidth_;
-  uint8_t srd_;
+  GyroBandwidth gyro_bandwidth_ = GYRO_BANDWIDTH_184HZ;
+  AccelBandwidth accel_bandwidth_ = ACCEL_BANDWIDTH_218HZ;
+  uint8_t srd_ = 0;
+  uint8_t smplrt_div_ = 0;
+  AuxI2cClock aux_i2c_clock_ = AUX_I2C_CLOCK_400KHZ;
+  bool drdy_int_en_ = false;
+  bool drdy_latch_ = false;
+  bool wom_en_ = false;
+  uint16_t wom_threshold_mg_ = 0;
+  LpAccelOdr wom_odr_ = LP_ACCEL_ODR_0_24HZ;
+  WriteVerify write_verify_ = WRITE_VERIFY;
+  static constexpr uint8_t WRITE_ATTEMPTS_ = 3;
+  /* Fault detection and recovery */
+  bool auto_recover_ = false;
+  Fault fault_ = FAULT_NONE;
+  uint8_t consecutive_faults_ = 0;
+  uint8_t frozen_reads_ = 0;
+  uint32_t recoveries_ = 0;
+  static constexpr uint8_t NO_PIN_ = 0xFF;
+  uint8_t i2c_scl_pin_ = NO_PIN_;
+  uint8_t i2c_sda_pin_ = NO_PIN_;
+  uint32_t last_sample_us_ = 0;
+  uint16_t spot_check_reads_ = 0;
+  static constexpr uint8_t STALL_PERIODS_ = 10;
+  static constexpr uint16_t SPOT_CHECK_READS_ = 1000;
+  static constexpr uint8_t FAULT_LIMIT_ = 3;
+  static constexpr uint8_t FROZEN_LIMIT_ = 50;
+  static constexpr uint8_t I2C_CLEAR_PULSES_ = 9;
+  static constexpr uint8_t MAX_WRITE_BURST_ = 8;
+  /* FIFO */
+  uint8_t fifo_en_ = 0;
+  uint8_t fifo_frame_size_ = 0;
+  size_t fifo_num_frames_ = 0;
+  uint32_t fifo_time_us_ = 0;
+  bool fifo_overflow_ = false;
+  static constexpr size_t FIFO_SIZE_ = 512;
   static constexpr uint8_t WHOAMI_MPU9250_ = 0x71;
   static constexpr uint8_t WHOAMI_MPU9255_ = 0x73;
   static constexpr uint8_t WHOAMI_AK8963_ = 0x48;
   /* Data */
+  static constexpr uint8_t DATA_LEN_ = 23;
+  static constexpr uint8_t IMU_DATA_LEN_ = 16;
+  static constexpr uint8_t MAG_DATA_LEN_ = 8;
+  bool mag_read_on_drdy_ = false;
+  bool new_mag_data_ = false;
+  int16_t accel_cnts_[3] = {}, gyro_cnts_[3] = {}, temp_cnts_ = 0;
+  int16_t mag_cnts_[3] = {};
   float accel_scale_, gyro_scale_, mag_scale_[3];
-  float temp_scale_ = 333.87f;
+  static constexpr float G_MPS2_ = 9.80665f;
+  static constexpr float DEG2RAD_ = 3.14159265358979323846f / 180.0f;
+  static constexpr float TEMP_SCALE_ = 1.0f / 333.87f;
+  static constexpr float TEMP_OFFSET_ = 21.0f - 21.0f / 333.87f;
+  /* Calibration */
+  float accel_bias_mps2_[3] = {};
+  float accel_sm_[3][3] = {{1.0f, 0.0f, 0.0f},
+                           {0.0f, 1.0f, 0.0f},
+                           {0.0f, 0.0f, 1.0f}};
+  float gyro_bias_radps_[3] = {};
+  float gyro_sm_[3][3] = {{1.0f, 0.0f, 0.0f},
+                          {0.0f, 1.0f, 0.0f},
+                          {0.0f, 0.0f, 1.0f}};
+  float mag_bias_ut_[3] = {};
+  float mag_sm_[3][3] = {{1.0f, 0.0f, 0.0f},
+                         {0.0f, 1.0f, 0.0f},
+                         {0.0f, 0.0f, 1.0f}};
+  HwOffsets hw_offsets_ = {};
+  /* Temperature compensation table and the current interpolation segment */
+  const TempCompPoint *tc_table_ = nullptr;
+  uint8_t tc_len_ = 0;
+  float tc_lo_c_ = 0.0f, tc_hi_c_ = 0.0f;
+  float tc_accel_b_[3], tc_accel_m_[3];
+  float tc_gyro_b_[3], tc_gyro_m_[3];
+  static constexpr uint16_t CAL_SAMPLES_ = 100;
+  static constexpr float GYRO_OFFSET_LSB_PER_DPS_ = 32.8f;
+  static constexpr float ACCEL_OFFSET_LSB_PER_G_ = 1024.0f;
+  static constexpr int16_t ACCEL_OFFSET_MIN_ = -16384;
+  static constexpr int16_t ACCEL_OFFSET_MAX_ = 16383;
+  /* Self test, AN-MPU-9250A-03 */
+  static constexpr uint8_t ST_SAMPLES_ = 50;
+  static constexpr uint8_t ST_SETTLE_MS_ = 20;
+  static constexpr uint8_t ST_MAG_TIMEOUT_MS_ = 20;
+  static constexpr float ST_OTP_BASE_ = 2620.0f;
+  static constexpr float ST_GYRO_MIN_RATIO_ = 0.5f;
+  static constexpr float ST_ACCEL_MIN_RATIO_ = 0.5f;
+  static constexpr float ST_ACCEL_MAX_RATIO_ = 1.5f;
+  /* Absolute limits when the trim is zero, 250 dps and 2 g full scale */
+  static constexpr float ST_GYRO_MIN_LSB_ = 60.0f * 131.0f;
+  static constexpr float ST_GYRO_MAX_OFFSET_LSB_ = 20.0f * 131.0f;
+  static constexpr float ST_ACCEL_MIN_LSB_ = 0.225f * 16384.0f;
+  static constexpr float ST_ACCEL_MAX_LSB_ = 0.675f * 16384.0f;
+  static constexpr int16_t ST_MAG_XY_LIMIT_ = 200;
+  static constexpr int16_t ST_MAG_Z_MIN_ = -3200;
+  static constexpr int16_t ST_MAG_Z_MAX_ = -800;
+  /* Scale factors, unit conversions, and calibration folded together */
+  struct Fold {
+    float scale[3][3];
+    float bias[3];
+    bool diag;
+  };
+  Fold accel_fold_, gyro_fold_, mag_fold_;
   float accel_mps2_[3];
   float gyro_radps_[3];
   float mag_ut_[3];
   float die_temperature_c_;
+  uint32_t time_us_ = 0;
+  Mpu9250Ring *ring_ = nullptr;
+  /* Data ready interrupt */
+  static constexpr uint8_t MAX_DRDY_ = 4;
+  static Mpu9250 *drdy_imus_[MAX_DRDY_];
+  static void (* const DRDY_ISRS_[MAX_DRDY_])();
+  bool drdy_attached_ = false;
+  volatile uint32_t drdy_time_us_ = 0;
+  volatile bool drdy_new_ = false;
+  void (*drdy_callback_)() = nullptr;
+  #if defined(MPU9250_STATS)
+  /* Driver statistics, missed_drdy is updated from the DRDY ISR */
+  Stats stats_ = {};
+  volatile bool drdy_pending_ = false;
+  #endif
+  #if defined(SPI_HAS_TRANSFER_ASYNC)
+  /* Asynchronous reads */
+  EventResponder async_event_;
+  uint32_t async_time_us_ = 0;
+  volatile bool async_busy_ = false;
+  volatile bool async_new_data_ = false;
+  /* Set around synchronous SPI transactions, async reads wait for them */
+  volatile bool sync_busy_ = false;
+  /* Recovery needs the bus, so it waits for an asynchronous read to finish */
+  volatile bool recover_pending_ = false;
+  void (*async_callback_)() = nullptr;
+  uint8_t async_tx_buff_[DATA_LEN_ + 1] = {};
+  uint8_t async_rx_buff_[DATA_LEN_ + 1];
+  /* Completed transfers are staged for AsyncReadComplete to unpack */
+  uint8_t async_data_buff_[DATA_LEN_];
+  uint32_t async_data_time_us_ = 0;
+  #endif
   /* Registers */
   static constexpr uint8_t PWR_MGMNT_1_ = 0x6B;
   static constexpr uint8_t H_RESET_ = 0x80;
   static constexpr uint8_t CLKSEL_PLL_ = 0x01;
+  static constexpr uint8_t PWR_CYCLE_ = 0x20;
+  static constexpr uint8_t PWR_MGMNT_2_ = 0x6C;
+  static constexpr uint8_t SEN_ENABLE_ = 0x00;
+  static constexpr uint8_t DIS_GYRO_ = 0x07;
   static constexpr uint8_t WHOAMI_ = 0x75;
+  static constexpr uint8_t XG_OFFSET_H_ = 0x13;
+  static constexpr uint8_t YG_OFFSET_H_ = 0x15;
+  static constexpr uint8_t ZG_OFFSET_H_ = 0x17;
+  static constexpr uint8_t XA_OFFSET_H_ = 0x77;
+  static constexpr uint8_t YA_OFFSET_H_ = 0x7A;
+  static constexpr uint8_t ZA_OFFSET_H_ = 0x7D;
   static constexpr uint8_t ACCEL_CONFIG_ = 0x1C;
   static constexpr uint8_t GYRO_CONFIG_ = 0x1B;
+  static constexpr uint8_t DLPF_CFG_MASK_ = 0x07;
   static constexpr uint8_t ACCEL_CONFIG2_ = 0x1D;
   static constexpr uint8_t CONFIG_ = 0x1A;
   static constexpr uint8_t SMPLRT_DIV_ = 0x19;
@@ -120,11 +466,31 @@ class Mpu9250 {
   static constexpr uint8_t INT_ENABLE_ = 0x38;
   static constexpr uint8_t INT_DISABLE_ = 0x00;
   static constexpr uint8_t INT_PULSE_50US_ = 0x00;
+  static constexpr uint8_t INT_LATCH_ANYRD_CLEAR_ = 0x30;
   static constexpr uint8_t INT_RAW_RDY_EN_ = 0x01;
+  static constexpr uint8_t INT_WOM_EN_ = 0x40;
+  static constexpr uint8_t MOT_DETECT_CTRL_ = 0x69;
+  static constexpr uint8_t ACCEL_INTEL_EN_ = 0x80;
+  static constexpr uint8_t ACCEL_INTEL_MODE_ = 0x40;
+  static constexpr uint8_t WOM_THR_ = 0x1F;
+  static constexpr uint8_t LP_ACCEL_ODR_ = 0x1E;
   static constexpr uint8_t INT_STATUS_ = 0x3A;
   static constexpr uint8_t RAW_DATA_RDY_INT_ = 0x01;
+  static constexpr uint8_t SELF_TEST_X_GYRO_ = 0x00;
+  static constexpr uint8_t SELF_TEST_X_ACCEL_ = 0x0D;
+  static constexpr uint8_t XYZ_SELF_TEST_EN_ = 0xE0;
   static constexpr uint8_t USER_CTRL_ = 0x6A;
   static constexpr uint8_t I2C_MST_EN_ = 0x20;
+  static constexpr uint8_t I2C_MST_RST_ = 0x02;
+  static constexpr uint8_t USER_FIFO_EN_ = 0x40;
+  static constexpr uint8_t FIFO_RST_ = 0x04;
+  static constexpr uint8_t FIFO_EN_ = 0x23;
+  static constexpr uint8_t FIFO_TEMP_EN_ = 0x80;
+  static constexpr uint8_t FIFO_GYRO_EN_ = 0x70;
+  static constexpr uint8_t FIFO_ACCEL_EN_ = 0x08;
+  static constexpr uint8_t FIFO_SLV0_EN_ = 0x01;
+  static constexpr uint8_t FIFO_COUNT_ = 0x72;
+  static constexpr uint8_t FIFO_R_W_ = 0x74;
   static constexpr uint8_t I2C_MST_CLK_ = 0x0D;
   static constexpr uint8_t I2C_MST_CTRL_ = 0x24;
   static constexpr uint8_t I2C_SLV0_ADDR_ = 0x25;
@@ -133,9 +499,20 @@ class Mpu9250 {
   static constexpr uint8_t I2C_SLV0_DO_ = 0x63;
   static constexpr uint8_t I2C_READ_FLAG_ = 0x80;
   static constexpr uint8_t I2C_SLV0_EN_ = 0x80;
+  static constexpr uint8_t I2C_SLV4_ADDR_ = 0x31;
+  static constexpr uint8_t I2C_SLV4_REG_ = 0x32;
+  static constexpr uint8_t I2C_SLV4_DO_ = 0x33;
+  static constexpr uint8_t I2C_SLV4_CTRL_ = 0x34;
+  static constexpr uint8_t I2C_SLV4_DI_ = 0x35;
+  static constexpr uint8_t I2C_SLV4_EN_ = 0x80;
+  static constexpr uint8_t I2C_MST_STATUS_ = 0x36;
+  static constexpr uint8_t I2C_SLV4_DONE_ = 0x40;
+  static constexpr uint8_t I2C_SLV4_NACK_ = 0x10;
   static constexpr uint8_t EXT_SENS_DATA_00_ = 0x49;
   /* AK8963 registers */
   static constexpr uint8_t AK8963_I2C_ADDR_ = 0x0C;
+  static constexpr uint8_t AK8963_ST1_ = 0x02;
+  static constexpr uint8_t AK8963_DRDY_ = 0x01;
   static constexpr uint8_t AK8963_HXL_ = 0x03;
   static constexpr uint8_t AK8963_CNTL1_ = 0x0A;
   static constexpr uint8_t AK8963_PWR_DOWN_ = 0x00;
@@ -146,10 +523,81 @@ class Mpu9250 {
   static constexpr uint8_t AK8963_RESET_ = 0x01;
   static constexpr uint8_t AK8963_ASA_ = 0x10;
   static constexpr uint8_t AK8963_WHOAMI_ = 0x00;
+  static constexpr uint8_t AK8963_ASTC_ = 0x0C;
+  static constexpr uint8_t AK8963_SELF_ = 0x40;
+  static constexpr uint8_t AK8963_SELF_TEST_16BIT_ = 0x18;
+  static constexpr uint8_t AK8963_ST2_ = 0x09;
+  bool UnpackData(const uint8_t * const data_buff);
+  template<uint8_t N>
+  static void DrdyIsr() {drdy_imus_[N]->DrdyHandler();}
+  void DrdyHandler();
+  uint32_t SampleTime(const uint32_t read_time_us);
+  uint32_t SamplePeriodNs() const;
+  static inline int16_t Negate(const int16_t val) {
+    return (val == -32768) ? 32767 : -val;
+  }
+  void BeginBus();
+  /*
+  * Claims the SPI bus for a synchronous transaction, failing while an
+  * asynchronous read is using it
+  */
+  inline bool BeginSpiAccess() {
+    #if defined(SPI_HAS_TRANSFER_ASYNC)
+    sync_busy_ = true;
+    if (async_busy_) {
+      sync_busy_ = false;
+      return false;
+    }
+    #endif
+    return true;
+  }
+  inline void EndSpiAccess() {
+    #if defined(SPI_HAS_TRANSFER_ASYNC)
+    sync_busy_ = false;
+    #endif
+  }
+  void ClearI2cBus();
+  bool CheckData(const uint8_t * const data_buff);
+  bool CheckConfig(bool * const intact);
+  void SpotCheck();
+  void RecordFault(const Fault fault);
+  static float AccelScale(const AccelRange range);
+  static float GyroScale(const GyroRange range);
+  static bool ValidGyroBandwidth(const GyroBandwidth bandwidth);
+  static bool ValidAccelBandwidth(const AccelBandwidth bandwidth);
+  bool WriteImuConfig(const AccelRange accel_range, const GyroRange gyro_range,
+                      const GyroBandwidth gyro_bandwidth,
+                      const AccelBandwidth accel_bandwidth,
+                      const uint8_t srd);
+  bool ReadHwOffsets();
+  bool SelfTestAverage(int32_t accel[3], int32_t gyro[3]);
+  bool SelfTestMag(float mag_cnts[3], const uint8_t srd);
+  static int32_t Round(const float val);
+  static int16_t Clamp(const int32_t val, const int16_t min,
+                       const int16_t max);
+  void FoldAccel();
+  void FoldGyro();
+  void FoldMag();
+  void UpdateTempComp(const float temp_c);
+  static void ComputeFold(const float axis_scale[3], const float bias[3],
+                          const float sm[3][3], Fold * const fold);
+  static void ApplyFold(const Fold &fold, const int16_t cnts[3],
+                        float out[3]);
+  #if defined(SPI_HAS_TRANSFER_ASYNC)
+  static void AsyncEventHandler(EventResponderRef event);
+  #endif
   bool WriteRegister(uint8_t reg, uint8_t data);
+  bool WriteRegister(uint8_t reg, uint8_t data, const WriteVerify verify);
+  bool WriteRegisters(uint8_t reg, uint8_t count, const uint8_t * const data);
   bool ReadRegisters(uint8_t reg, uint8_t count, uint8_t *data);
+  bool ReadRegisters(uint8_t reg, uint8_t count, uint8_t *data,
+                     const SPISettings &settings);
+  void SpiReadRegisters(uint8_t reg, uint8_t count, uint8_t *data);
   bool WriteAk8963Register(uint8_t reg, uint8_t data);
+  bool WriteAk8963Register(uint8_t reg, uint8_t data,
+                           const WriteVerify verify);
   bool ReadAk8963Registers(uint8_t reg, uint8_t count, uint8_t *data);
+  bool ConfigAk8963Mode(const uint8_t mode);
 };
 
 #endif  // INCLUDE_MPU9250_MPU9250_H_
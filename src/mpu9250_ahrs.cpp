@@ -0,0 +1,186 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "mpu9250.h"
+#include "mpu9250_ahrs.h"
+#include <math.h>
+
+void Mpu9250Ahrs::ConfigGains(const float kp, const float ki) {
+  kp_ = kp;
+  ki_ = ki;
+}
+void Mpu9250Ahrs::Update(const Mpu9250 &imu) {
+  const float gyro_radps[3] = {imu.gyro_x_radps(), imu.gyro_y_radps(),
+                               imu.gyro_z_radps()};
+  const float accel_mps2[3] = {imu.accel_x_mps2(), imu.accel_y_mps2(),
+                               imu.accel_z_mps2()};
+  const float mag_ut[3] = {imu.mag_x_ut(), imu.mag_y_ut(), imu.mag_z_ut()};
+  Filter(imu.time_us(), gyro_radps, accel_mps2, mag_ut);
+}
+void Mpu9250Ahrs::Update(const Mpu9250::Sample &sample) {
+  Filter(sample.time_us, sample.gyro_radps, sample.accel_mps2,
+         sample.mag_ut);
+}
+void Mpu9250Ahrs::Reset() {
+  init_ = false;
+  q_[0] = 1.0f;
+  for (uint8_t i = 0; i < 3; i++) {
+    q_[i + 1] = 0.0f;
+    integral_[i] = 0.0f;
+  }
+}
+void Mpu9250Ahrs::quat(float q[4]) const {
+  for (uint8_t i = 0; i < 4; i++) {
+    q[i] = q_[i];
+  }
+}
+float Mpu9250Ahrs::pitch_rad() const {
+  float s = 2.0f * (q_[0] * q_[2] - q_[3] * q_[1]);
+  /* Clamp the rounding error at +/-90 deg */
+  if (s > 1.0f) {
+    s = 1.0f;
+  } else if (s < -1.0f) {
+    s = -1.0f;
+  }
+  return asinf(s);
+}
+void Mpu9250Ahrs::Filter(const uint32_t time_us, const float gyro_radps[3],
+                         const float accel_mps2[3], const float mag_ut[3]) {
+  /* At rest the accel measures -g on z, so negate it to point down */
+  float down[3] = {-accel_mps2[0], -accel_mps2[1], -accel_mps2[2]};
+  float mag[3] = {mag_ut[0], mag_ut[1], mag_ut[2]};
+  bool accel_valid = Normalize(down);
+  bool mag_valid = (use_mag_) && (Normalize(mag));
+  /* The first sample sets the attitude directly for fast convergence */
+  if (!init_) {
+    if (!accel_valid) {
+      return;
+    }
+    Init(down, mag, mag_valid);
+    prev_time_us_ = time_us;
+    init_ = true;
+    return;
+  }
+  uint32_t dt_us = time_us - prev_time_us_;
+  prev_time_us_ = time_us;
+  if ((!dt_us) || (dt_us > MAX_DT_US_)) {
+    return;
+  }
+  const float dt_s = static_cast<float>(dt_us) * 1e-6f;
+  float q0 = q_[0], q1 = q_[1], q2 = q_[2], q3 = q_[3];
+  float gx = gyro_radps[0], gy = gyro_radps[1], gz = gyro_radps[2];
+  if (accel_valid) {
+    /* Estimated direction of gravity in the sensor frame */
+    float vx = 2.0f * (q1 * q3 - q0 * q2);
+    float vy = 2.0f * (q0 * q1 + q2 * q3);
+    float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+    float ex = down[1] * vz - down[2] * vy;
+    float ey = down[2] * vx - down[0] * vz;
+    float ez = down[0] * vy - down[1] * vx;
+    if (mag_valid) {
+      /* Rotate the field to NED and keep only its north and down parts */
+      float hx = 2.0f * (mag[0] * (0.5f - q2 * q2 - q3 * q3) +
+                         mag[1] * (q1 * q2 - q0 * q3) +
+                         mag[2] * (q1 * q3 + q0 * q2));
+      float hy = 2.0f * (mag[0] * (q1 * q2 + q0 * q3) +
+                         mag[1] * (0.5f - q1 * q1 - q3 * q3) +
+                         mag[2] * (q2 * q3 - q0 * q1));
+      float bx = sqrtf(hx * hx + hy * hy);
+      float bz = 2.0f * (mag[0] * (q1 * q3 - q0 * q2) +
+                         mag[1] * (q2 * q3 + q0 * q1) +
+                         mag[2] * (0.5f - q1 * q1 - q2 * q2));
+      /* Estimated direction of the field in the sensor frame */
+      float wx = 2.0f * (bx * (0.5f - q2 * q2 - q3 * q3) +
+                         bz * (q1 * q3 - q0 * q2));
+      float wy = 2.0f * (bx * (q1 * q2 - q0 * q3) + bz * (q0 * q1 + q2 * q3));
+      float wz = 2.0f * (bx * (q0 * q2 + q1 * q3) +
+                         bz * (0.5f - q1 * q1 - q2 * q2));
+      ex += mag[1] * wz - mag[2] * wy;
+      ey += mag[2] * wx - mag[0] * wz;
+      ez += mag[0] * wy - mag[1] * wx;
+    }
+    /* Proportional and integral feedback on the gyro */
+    if (ki_ > 0.0f) {
+      integral_[0] += ki_ * ex * dt_s;
+      integral_[1] += ki_ * ey * dt_s;
+      integral_[2] += ki_ * ez * dt_s;
+      gx += integral_[0];
+      gy += integral_[1];
+      gz += integral_[2];
+    }
+    gx += kp_ * ex;
+    gy += kp_ * ey;
+    gz += kp_ * ez;
+  }
+  /* Integrate the quaternion rate, 1/2 q x [0 w] */
+  const float h = 0.5f * dt_s;
+  q_[0] = q0 + (-q1 * gx - q2 * gy - q3 * gz) * h;
+  q_[1] = q1 + (q0 * gx + q2 * gz - q3 * gy) * h;
+  q_[2] = q2 + (q0 * gy - q1 * gz + q3 * gx) * h;
+  q_[3] = q3 + (q0 * gz + q1 * gy - q2 * gx) * h;
+  float norm = 1.0f / sqrtf(q_[0] * q_[0] + q_[1] * q_[1] + q_[2] * q_[2] +
+                            q_[3] * q_[3]);
+  for (uint8_t i = 0; i < 4; i++) {
+    q_[i] *= norm;
+  }
+}
+void Mpu9250Ahrs::Init(const float down[3], const float mag[3],
+                       const bool mag_valid) {
+  const float roll = atan2f(down[1], down[2]);
+  const float pitch = atan2f(-down[0], sqrtf(down[1] * down[1] +
+                                             down[2] * down[2]));
+  float yaw = 0.0f;
+  if (mag_valid) {
+    /* Tilt compensated heading */
+    const float cr = cosf(roll), sr = sinf(roll);
+    const float cp = cosf(pitch), sp = sinf(pitch);
+    const float mx = mag[0] * cp + (mag[1] * sr + mag[2] * cr) * sp;
+    const float my = mag[1] * cr - mag[2] * sr;
+    yaw = atan2f(-my, mx);
+  }
+  /* Yaw, pitch, roll sequence to quaternion */
+  const float cy = cosf(0.5f * yaw), sy = sinf(0.5f * yaw);
+  const float cp = cosf(0.5f * pitch), sp = sinf(0.5f * pitch);
+  const float cr = cosf(0.5f * roll), sr = sinf(0.5f * roll);
+  q_[0] = cr * cp * cy + sr * sp * sy;
+  q_[1] = sr * cp * cy - cr * sp * sy;
+  q_[2] = cr * sp * cy + sr * cp * sy;
+  q_[3] = cr * cp * sy - sr * sp * cy;
+  for (uint8_t i = 0; i < 3; i++) {
+    integral_[i] = 0.0f;
+  }
+}
+bool Mpu9250Ahrs::Normalize(float v[3]) {
+  float norm_sq = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+  if (norm_sq <= 0.0f) {
+    return false;
+  }
+  float inv = 1.0f / sqrtf(norm_sq);
+  for (uint8_t i = 0; i < 3; i++) {
+    v[i] *= inv;
+  }
+  return true;
+}
@@ -0,0 +1,73 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_AHRS_H_
+#define INCLUDE_MPU9250_MPU9250_AHRS_H_
+
+#include "Arduino.h"
+#include "mpu9250.h"
+
+/*
+* Mahony complementary filter estimating attitude from the converted gyro,
+* accel, and magnetometer data. The quaternion rotates from the sensor
+* common axis system (x forward, y right, z down) to north-east-down.
+*/
+class Mpu9250Ahrs {
+ public:
+  void ConfigGains(const float kp, const float ki);
+  inline float kp() const {return kp_;}
+  inline float ki() const {return ki_;}
+  inline void ConfigUseMag(const bool en) {use_mag_ = en;}
+  inline bool use_mag() const {return use_mag_;}
+  void Update(const Mpu9250 &imu);
+  void Update(const Mpu9250::Sample &sample);
+  void Reset();
+  void quat(float q[4]) const;
+  inline float roll_rad() const {
+    return atan2f(2.0f * (q_[0] * q_[1] + q_[2] * q_[3]),
+                  1.0f - 2.0f * (q_[1] * q_[1] + q_[2] * q_[2]));
+  }
+  float pitch_rad() const;
+  inline float yaw_rad() const {
+    return atan2f(2.0f * (q_[0] * q_[3] + q_[1] * q_[2]),
+                  1.0f - 2.0f * (q_[2] * q_[2] + q_[3] * q_[3]));
+  }
+
+ private:
+  void Filter(const uint32_t time_us, const float gyro_radps[3],
+              const float accel_mps2[3], const float mag_ut[3]);
+  void Init(const float down[3], const float mag[3], const bool mag_valid);
+  static bool Normalize(float v[3]);
+  float kp_ = 1.0f, ki_ = 0.0f;
+  bool use_mag_ = true;
+  bool init_ = false;
+  uint32_t prev_time_us_ = 0;
+  float q_[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+  float integral_[3] = {};
+  /* Larger gaps restart the time reference rather than integrating */
+  static constexpr uint32_t MAX_DT_US_ = 100000;
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_AHRS_H_
@@ -0,0 +1,48 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_BUS_H_
+#define INCLUDE_MPU9250_MPU9250_BUS_H_
+
+#include "Arduino.h"
+
+/*
+* Register level bus interface, allowing the Mpu9250 to run on a custom bus
+* or a simulated sensor. Reads and writes start at register reg and auto
+* increment through count registers. The bus selects its own clocks.
+*/
+class Mpu9250Bus {
+ public:
+  virtual void Begin() = 0;
+  virtual bool WriteRegisters(const uint8_t reg, const uint8_t count,
+                              const uint8_t * const data) = 0;
+  virtual bool ReadRegisters(const uint8_t reg, const uint8_t count,
+                             uint8_t * const data) = 0;
+
+ protected:
+  ~Mpu9250Bus() {}
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_BUS_H_
@@ -0,0 +1,244 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_CORE_H_
+#define INCLUDE_MPU9250_MPU9250_CORE_H_
+
+#include "Arduino.h"
+#include "mpu9250.h"
+
+/*
+* Register sequences shared by the Mpu9250 and Mpu9250T front ends. Dev
+* provides the register access, WriteRegister and ReadRegisters, with its
+* own bus and write verification, and the smplrt_div_ and srd_ members.
+*/
+template<typename Dev>
+class Mpu9250Core {
+ public:
+  /*
+  * Resets the MPU-9250 and AK8963 and checks both WHO AM I bytes, leaving
+  * the I2C master enabled at aux_clock and an SRD of 0
+  */
+  static bool Reset(Dev * const dev, const uint8_t aux_clock) {
+    /* Select clock source to gyro */
+    if (!dev->WriteRegister(M::PWR_MGMNT_1_, M::CLKSEL_PLL_)) {
+      return false;
+    }
+    /* Enable I2C master mode */
+    if (!dev->WriteRegister(M::USER_CTRL_, M::I2C_MST_EN_)) {
+      return false;
+    }
+    /* Set the auxiliary I2C bus speed */
+    if (!dev->WriteRegister(M::I2C_MST_CTRL_, aux_clock)) {
+      return false;
+    }
+    /* Set AK8963 to power down */
+    WriteAk8963Register(dev, M::AK8963_CNTL1_, M::AK8963_PWR_DOWN_);
+    /* Reset the MPU9250, H_RESET self clears so it can't be verified */
+    dev->WriteRegister(M::PWR_MGMNT_1_, M::H_RESET_, M::WRITE_VERIFY_NONE);
+    dev->smplrt_div_ = 0;
+    dev->srd_ = 0;
+    /* Wait for MPU-9250 to come back up */
+    delay(10);
+    /* Select clock source to gyro */
+    if (!dev->WriteRegister(M::PWR_MGMNT_1_, M::CLKSEL_PLL_)) {
+      return false;
+    }
+    /* Check the WHO AM I byte */
+    uint8_t who_am_i;
+    if (!dev->ReadRegisters(M::WHOAMI_, sizeof(who_am_i), &who_am_i)) {
+      return false;
+    }
+    if ((who_am_i != M::WHOAMI_MPU9250_) && (who_am_i != M::WHOAMI_MPU9255_)) {
+      return false;
+    }
+    /* The reset disabled the I2C master, enable it again */
+    if (!dev->WriteRegister(M::USER_CTRL_, M::I2C_MST_EN_)) {
+      return false;
+    }
+    if (!dev->WriteRegister(M::I2C_MST_CTRL_, aux_clock)) {
+      return false;
+    }
+    /* Reset the AK8963, SRST self clears so it can't be verified */
+    WriteAk8963Register(dev, M::AK8963_CNTL2_, M::AK8963_RESET_,
+                        M::WRITE_VERIFY_NONE);
+    /* Check the AK8963 WHOAMI */
+    if (!ReadAk8963Registers(dev, M::AK8963_WHOAMI_, sizeof(who_am_i),
+                             &who_am_i)) {
+      return false;
+    }
+    return (who_am_i == M::WHOAMI_AK8963_);
+  }
+  /* Reads the AK8963 FUSE ROM sensitivity adjustment, uT / count */
+  static bool ReadMagScale(Dev * const dev, float mag_scale[3]) {
+    /* Set AK8963 to power down, then FUSE ROM access */
+    if (!WriteAk8963Register(dev, M::AK8963_CNTL1_, M::AK8963_PWR_DOWN_)) {
+      return false;
+    }
+    if (!WriteAk8963Register(dev, M::AK8963_CNTL1_, M::AK8963_FUSE_ROM_)) {
+      return false;
+    }
+    uint8_t asa_buff[3] = {};
+    if (!ReadAk8963Registers(dev, M::AK8963_ASA_, sizeof(asa_buff), asa_buff)) {
+      return false;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+      mag_scale[i] = ((static_cast<float>(asa_buff[i]) - 128.0f)
+        / 256.0f + 1.0f) * 4912.0f / 32760.0f;
+    }
+    return true;
+  }
+  /* Sets the SRD along with the 8 Hz or 100 Hz magnetometer rate it needs */
+  static bool ConfigSrd(Dev * const dev, const uint8_t srd) {
+    /*
+    * Run the I2C master at the full rate while the AK8963 is set up, each
+    * SLV4 transaction waits up to one sample period
+    */
+    if (!dev->WriteRegister(M::SMPLRT_DIV_, 0)) {
+      return false;
+    }
+    dev->smplrt_div_ = 0;
+    if (!ConfigAk8963Mode(dev, (srd > 9) ? M::AK8963_CNT_MEAS1_ :
+                          M::AK8963_CNT_MEAS2_)) {
+      return false;
+    }
+    /* Set the IMU sample rate */
+    if (!dev->WriteRegister(M::SMPLRT_DIV_, srd)) {
+      return false;
+    }
+    dev->smplrt_div_ = srd;
+    dev->srd_ = srd;
+    return true;
+  }
+  static bool ConfigAk8963Mode(Dev * const dev, const uint8_t mode) {
+    /*
+    * Set AK8963 to power down, the AK8963 needs 100 us in power down before
+    * a new mode is set, which waiting on the I2C master already covers
+    */
+    WriteAk8963Register(dev, M::AK8963_CNTL1_, M::AK8963_PWR_DOWN_);
+    if (!WriteAk8963Register(dev, M::AK8963_CNTL1_, mode)) {
+      return false;
+    }
+    /*
+    * Instruct the MPU9250 to get 8 bytes, ST1 through ST2, from the AK8963 at
+    * the sample rate using SLV0
+    */
+    if (!dev->WriteRegister(M::I2C_SLV0_ADDR_,
+                            M::AK8963_I2C_ADDR_ | M::I2C_READ_FLAG_)) {
+      return false;
+    }
+    if (!dev->WriteRegister(M::I2C_SLV0_REG_, M::AK8963_ST1_)) {
+      return false;
+    }
+    return dev->WriteRegister(M::I2C_SLV0_CTRL_,
+                              M::I2C_SLV0_EN_ | M::MAG_DATA_LEN_);
+  }
+  static bool WriteAk8963Register(Dev * const dev, const uint8_t reg,
+                                  const uint8_t data) {
+    return WriteAk8963Register(dev, reg, data, dev->write_verify_);
+  }
+  static bool WriteAk8963Register(Dev * const dev, const uint8_t reg,
+                                  const uint8_t data,
+                                  const Mpu9250::WriteVerify verify) {
+    uint8_t ret_val;
+    uint8_t attempts = (verify == M::WRITE_VERIFY_RETRY) ?
+                       M::WRITE_ATTEMPTS_ : 1;
+    for (uint8_t i = 0; i < attempts; i++) {
+      /* One-shot writes use SLV4, leaving SLV0 sampling undisturbed */
+      if (!Slv4Transfer(dev, M::AK8963_I2C_ADDR_, reg, data, nullptr)) {
+        continue;
+      }
+      if (verify == M::WRITE_VERIFY_NONE) {
+        return true;
+      }
+      if ((ReadAk8963Registers(dev, reg, sizeof(ret_val), &ret_val)) &&
+          (data == ret_val)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  static bool ReadAk8963Registers(Dev * const dev, const uint8_t reg,
+                                  const uint8_t count, uint8_t * const data) {
+    /* SLV4 transfers a single byte at a time */
+    for (uint8_t i = 0; i < count; i++) {
+      if (!Slv4Transfer(dev, M::AK8963_I2C_ADDR_ | M::I2C_READ_FLAG_, reg + i,
+                        0x00, data + i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  typedef Mpu9250 M;
+  static bool Slv4Transfer(Dev * const dev, const uint8_t addr,
+                           const uint8_t reg, const uint8_t data_out,
+                           uint8_t * const data_in) {
+    /* Clear any stale SLV4 status, I2C_MST_STATUS clears on read */
+    uint8_t status;
+    if (!dev->ReadRegisters(M::I2C_MST_STATUS_, sizeof(status), &status)) {
+      return false;
+    }
+    if (!dev->WriteRegister(M::I2C_SLV4_ADDR_, addr)) {
+      return false;
+    }
+    if (!dev->WriteRegister(M::I2C_SLV4_REG_, reg)) {
+      return false;
+    }
+    if ((!data_in) && (!dev->WriteRegister(M::I2C_SLV4_DO_, data_out))) {
+      return false;
+    }
+    /* I2C_SLV4_EN self clears when the transfer completes */
+    if (!dev->WriteRegister(M::I2C_SLV4_CTRL_, M::I2C_SLV4_EN_,
+                            M::WRITE_VERIFY_NONE)) {
+      return false;
+    }
+    /*
+    * The I2C master runs its slave transactions once per sample, so poll for
+    * I2C_SLV4_DONE for up to one sample period, at most (1 + SMPLRT_DIV) ms,
+    * plus 1 ms for the transaction
+    */
+    uint32_t timeout_ms = static_cast<uint32_t>(dev->smplrt_div_) + 2;
+    uint32_t t0 = millis();
+    do {
+      if (!dev->ReadRegisters(M::I2C_MST_STATUS_, sizeof(status), &status)) {
+        return false;
+      }
+      if (status & M::I2C_SLV4_DONE_) {
+        if (status & M::I2C_SLV4_NACK_) {
+          return false;
+        }
+        if (data_in) {
+          return dev->ReadRegisters(M::I2C_SLV4_DI_, sizeof(*data_in), data_in);
+        }
+        return true;
+      }
+    } while ((millis() - t0) <= timeout_ms);
+    return false;
+  }
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_CORE_H_
@@ -0,0 +1,159 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "mpu9250.h"
+#include "mpu9250_decimator.h"
+
+bool Mpu9250Decimator::Config(const uint8_t factor) {
+  /* Power of 2 factors scale by a shift rather than a divide */
+  if ((factor < 2) || (factor > MAX_FACTOR) || (factor & (factor - 1))) {
+    return false;
+  }
+  factor_ = factor;
+  shift_ = 0;
+  while ((1 << shift_) < factor_) {
+    shift_++;
+  }
+  /* The CIC gain is factor^ORDER */
+  shift_ *= ORDER;
+  Reset();
+  return true;
+}
+void Mpu9250Decimator::Reset() {
+  count_ = 0;
+  new_mag_data_ = false;
+  for (uint8_t k = 0; k < ORDER; k++) {
+    for (uint8_t ch = 0; ch < NUM_CH_; ch++) {
+      integ_[k][ch] = 0;
+      comb_[k][ch] = 0;
+    }
+  }
+}
+bool Mpu9250Decimator::Update(Mpu9250 * const imu) {
+  if ((!imu) || (!factor_)) {
+    return false;
+  }
+  int16_t in[NUM_CH_];
+  for (uint8_t i = 0; i < 3; i++) {
+    in[i] = imu->accel_cnts_[i];
+    in[i + 3] = imu->gyro_cnts_[i];
+  }
+  /* Integrators run at the input rate */
+  for (uint8_t ch = 0; ch < NUM_CH_; ch++) {
+    integ_[0][ch] += static_cast<uint32_t>(static_cast<int32_t>(in[ch]));
+  }
+  for (uint8_t k = 1; k < ORDER; k++) {
+    for (uint8_t ch = 0; ch < NUM_CH_; ch++) {
+      integ_[k][ch] += integ_[k - 1][ch];
+    }
+  }
+  /* A magnetometer sample anywhere in the window is reported */
+  new_mag_data_ = new_mag_data_ || imu->new_mag_data_;
+  if (++count_ < factor_) {
+    return false;
+  }
+  count_ = 0;
+  /* Combs run at the output rate */
+  uint32_t out[NUM_CH_];
+  for (uint8_t ch = 0; ch < NUM_CH_; ch++) {
+    out[ch] = integ_[ORDER - 1][ch];
+  }
+  for (uint8_t k = 0; k < ORDER; k++) {
+    for (uint8_t ch = 0; ch < NUM_CH_; ch++) {
+      uint32_t prev = comb_[k][ch];
+      comb_[k][ch] = out[ch];
+      out[ch] -= prev;
+    }
+  }
+  int16_t cnts[NUM_CH_];
+  for (uint8_t ch = 0; ch < NUM_CH_; ch++) {
+    int32_t val = static_cast<int32_t>(out[ch]);
+    val = (val + (static_cast<int32_t>(1) << (shift_ - 1))) >> shift_;
+    if (val > 32767) {
+      val = 32767;
+    } else if (val < -32768) {
+      val = -32768;
+    }
+    cnts[ch] = static_cast<int16_t>(val);
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    imu->accel_cnts_[i] = cnts[i];
+    imu->gyro_cnts_[i] = cnts[i + 3];
+  }
+  imu->new_mag_data_ = new_mag_data_;
+  new_mag_data_ = false;
+  /* Shift the timestamp back by the group delay, ORDER * (factor - 1) / 2 */
+  imu->time_us_ -= static_cast<uint32_t>(
+    static_cast<uint64_t>(ORDER * (factor_ - 1)) * imu->SamplePeriodNs() /
+    2000);
+  return true;
+}
+size_t Mpu9250Decimator::Process(Mpu9250 * const imu,
+                                 const uint8_t * const data) {
+  if ((!imu) || (!data)) {
+    return 0;
+  }
+  size_t num_out = 0;
+  bool stale = false;
+  int16_t accel_cnts[3], gyro_cnts[3], mag_cnts[3], temp_cnts = 0;
+  uint32_t time_us = 0;
+  bool new_mag_data = false;
+  for (size_t i = 0; i < imu->fifo_num_frames(); i++) {
+    if (!imu->UnpackFifoRaw(data, i)) {
+      break;
+    }
+    if (Update(imu)) {
+      imu->Convert();
+      num_out++;
+      stale = false;
+      for (uint8_t j = 0; j < 3; j++) {
+        accel_cnts[j] = imu->accel_cnts_[j];
+        gyro_cnts[j] = imu->gyro_cnts_[j];
+        mag_cnts[j] = imu->mag_cnts_[j];
+      }
+      temp_cnts = imu->temp_cnts_;
+      time_us = imu->time_us_;
+      new_mag_data = imu->new_mag_data_;
+    } else {
+      stale = true;
+    }
+  }
+  /*
+  * Frames unpacked after the last output leave their raw counts in the imu,
+  * so the last decimated output is restored to match the converted data
+  */
+  if ((num_out) && (stale)) {
+    for (uint8_t j = 0; j < 3; j++) {
+      imu->accel_cnts_[j] = accel_cnts[j];
+      imu->gyro_cnts_[j] = gyro_cnts[j];
+      imu->mag_cnts_[j] = mag_cnts[j];
+    }
+    imu->temp_cnts_ = temp_cnts;
+    imu->time_us_ = time_us;
+    imu->new_mag_data_ = new_mag_data;
+  }
+  return num_out;
+}
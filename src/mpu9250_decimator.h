@@ -0,0 +1,59 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_DECIMATOR_H_
+#define INCLUDE_MPU9250_MPU9250_DECIMATOR_H_
+
+#include "Arduino.h"
+#include "mpu9250.h"
+
+/*
+* Third order CIC decimator over the raw accel and gyro counts of FIFO
+* frames. The integrators use wrapping 32 bit arithmetic, so factors up to
+* 32 (15 bits of growth) fit, and the comb output is scaled back to counts
+* with a rounding shift. Temperature and magnetometer data are passed
+* through from the latest frame.
+*/
+class Mpu9250Decimator {
+ public:
+  static constexpr uint8_t ORDER = 3;
+  static constexpr uint8_t MAX_FACTOR = 32;
+  bool Config(const uint8_t factor);
+  inline uint8_t factor() const {return factor_;}
+  void Reset();
+  bool Update(Mpu9250 * const imu);
+  size_t Process(Mpu9250 * const imu, const uint8_t * const data);
+
+ private:
+  static constexpr uint8_t NUM_CH_ = 6;
+  uint8_t factor_ = 0;
+  uint8_t shift_ = 0;
+  uint8_t count_ = 0;
+  bool new_mag_data_ = false;
+  uint32_t integ_[ORDER][NUM_CH_] = {};
+  uint32_t comb_[ORDER][NUM_CH_] = {};
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_DECIMATOR_H_
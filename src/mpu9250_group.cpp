@@ -0,0 +1,113 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "mpu9250.h"
+#include "mpu9250_group.h"
+
+Mpu9250Group::Mpu9250Group(Mpu9250 * const * const imus, const uint8_t num) {
+  num_imus_ = (num > MAX_IMUS) ? MAX_IMUS : num;
+  for (uint8_t i = 0; i < num_imus_; i++) {
+    imus_[i] = imus[i];
+  }
+}
+bool Mpu9250Group::Read() {
+  if (!num_imus_) {
+    return false;
+  }
+  /* All of the IMUs must be on the same SPI bus */
+  SPIClass *spi = imus_[0]->spi_;
+  /* The transaction runs at the slowest data clock in the group */
+  const Mpu9250 *slowest = imus_[0];
+  for (uint8_t i = 0; i < num_imus_; i++) {
+    new_data_[i] = false;
+    if ((imus_[i]->iface_ != Mpu9250::SPI) || (imus_[i]->spi_ != spi)) {
+      return false;
+    }
+    if (imus_[i]->spi_data_clock_ < slowest->spi_data_clock_) {
+      slowest = imus_[i];
+    }
+  }
+  /* None of the IMUs may be in the middle of an asynchronous read */
+  for (uint8_t i = 0; i < num_imus_; i++) {
+    if (!imus_[i]->BeginSpiAccess()) {
+      for (uint8_t j = 0; j < i; j++) {
+        imus_[j]->EndSpiAccess();
+      }
+      return false;
+    }
+  }
+  /* Read all of the IMUs back to back in a single bus transaction */
+  uint8_t data_buff[MAX_IMUS][Mpu9250::DATA_LEN_];
+  #if defined(MPU9250_STATS)
+  uint32_t read_us[MAX_IMUS];
+  #endif
+  time_us_ = micros();
+  spi->beginTransaction(slowest->spi_data_settings_);
+  for (uint8_t i = 0; i < num_imus_; i++) {
+    /* The group consumes the sample, so a later Read waits for the next */
+    imus_[i]->drdy_new_ = false;
+    #if defined(MPU9250_STATS)
+    uint32_t t0 = micros();
+    #endif
+    imus_[i]->SpiReadRegisters(Mpu9250::INT_STATUS_, Mpu9250::DATA_LEN_,
+                               data_buff[i]);
+    #if defined(MPU9250_STATS)
+    read_us[i] = micros() - t0;
+    #endif
+  }
+  spi->endTransaction();
+  for (uint8_t i = 0; i < num_imus_; i++) {
+    imus_[i]->EndSpiAccess();
+  }
+  /*
+  * Check and unpack after the bus is released, a faulty IMU only drops out
+  * of the group, with its fault recorded and recovered as for a single read
+  */
+  bool status = false;
+  for (uint8_t i = 0; i < num_imus_; i++) {
+    Mpu9250 *imu = imus_[i];
+    #if defined(MPU9250_STATS)
+    if (read_us[i] > imu->stats_.max_read_us) {
+      imu->stats_.max_read_us = read_us[i];
+    }
+    imu->stats_.total_read_us += read_us[i];
+    #endif
+    new_data_[i] = (imu->CheckData(data_buff[i])) &&
+                   (imu->UnpackData(data_buff[i]));
+    if (new_data_[i]) {
+      imu->time_us_ = imu->SampleTime(time_us_);
+      imu->Convert();
+      status = true;
+      /* Periodically check that the sensor hasn't been reset or replaced */
+      if ((imu->auto_recover_) &&
+          (++imu->spot_check_reads_ >= Mpu9250::SPOT_CHECK_READS_)) {
+        imu->SpotCheck();
+      }
+    }
+  }
+  return status;
+}
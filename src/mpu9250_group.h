@@ -0,0 +1,54 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_GROUP_H_
+#define INCLUDE_MPU9250_MPU9250_GROUP_H_
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "mpu9250.h"
+
+class Mpu9250Group {
+ public:
+  static constexpr uint8_t MAX_IMUS = 8;
+  Mpu9250Group(Mpu9250 * const * const imus, const uint8_t num);
+  bool Read();
+  inline uint8_t num_imus() const {return num_imus_;}
+  inline Mpu9250 *imu(const uint8_t i) const {
+    return (i < num_imus_) ? imus_[i] : nullptr;
+  }
+  inline bool new_data(const uint8_t i) const {
+    return (i < num_imus_) ? new_data_[i] : false;
+  }
+  inline uint32_t time_us() const {return time_us_;}
+
+ private:
+  Mpu9250 *imus_[MAX_IMUS];
+  uint8_t num_imus_ = 0;
+  bool new_data_[MAX_IMUS] = {};
+  uint32_t time_us_ = 0;
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_GROUP_H_
@@ -0,0 +1,113 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "mpu9250.h"
+#include "mpu9250_integrator.h"
+
+void Mpu9250Integrator::Update(const Mpu9250 &imu) {
+  const float gyro_radps[3] = {imu.gyro_x_radps(), imu.gyro_y_radps(),
+                               imu.gyro_z_radps()};
+  const float accel_mps2[3] = {imu.accel_x_mps2(), imu.accel_y_mps2(),
+                               imu.accel_z_mps2()};
+  Integrate(imu.time_us(), gyro_radps, accel_mps2);
+}
+void Mpu9250Integrator::Update(const Mpu9250::Sample &sample) {
+  Integrate(sample.time_us, sample.gyro_radps, sample.accel_mps2);
+}
+void Mpu9250Integrator::Reset() {
+  for (uint8_t i = 0; i < 3; i++) {
+    alpha_[i] = 0;
+    nu_[i] = 0;
+    beta_[i] = 0;
+    scul_[i] = 0;
+  }
+  dt_s_ = 0;
+  num_samples_ = 0;
+}
+void Mpu9250Integrator::delta_angle_rad(float dtheta_rad[3]) const {
+  for (uint8_t i = 0; i < 3; i++) {
+    dtheta_rad[i] = alpha_[i] + beta_[i];
+  }
+}
+void Mpu9250Integrator::delta_velocity_mps(float dv_mps[3]) const {
+  /* Rotation compensation, 1/2 alpha x nu, is applied at the interval end */
+  float rot[3];
+  Cross(alpha_, nu_, rot);
+  for (uint8_t i = 0; i < 3; i++) {
+    dv_mps[i] = nu_[i] + 0.5f * rot[i] + scul_[i];
+  }
+}
+void Mpu9250Integrator::Integrate(const uint32_t time_us,
+                                  const float gyro_radps[3],
+                                  const float accel_mps2[3]) {
+  /* The first sample only sets the time reference */
+  if (!init_) {
+    init_ = true;
+    prev_time_us_ = time_us;
+    return;
+  }
+  /* Unsigned difference handles the micros rollover */
+  uint32_t dt_us = time_us - prev_time_us_;
+  prev_time_us_ = time_us;
+  if (!dt_us) {
+    return;
+  }
+  float dt_s = static_cast<float>(dt_us) * 1e-6f;
+  float dtheta[3], dv[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    dtheta[i] = gyro_radps[i] * dt_s;
+    dv[i] = accel_mps2[i] * dt_s;
+  }
+  /*
+  * Coning: dbeta = 1/2 (alpha + 1/6 prev_dtheta) x dtheta
+  * Sculling: 1/2 (alpha + 1/6 prev_dtheta) x dv +
+  *           1/2 (nu + 1/6 prev_dv) x dtheta
+  */
+  float a[3], n[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    a[i] = alpha_[i] + prev_dtheta_[i] / 6.0f;
+    n[i] = nu_[i] + prev_dv_[i] / 6.0f;
+  }
+  float cone[3], scul_a[3], scul_n[3];
+  Cross(a, dtheta, cone);
+  Cross(a, dv, scul_a);
+  Cross(n, dtheta, scul_n);
+  for (uint8_t i = 0; i < 3; i++) {
+    beta_[i] += 0.5f * cone[i];
+    scul_[i] += 0.5f * (scul_a[i] + scul_n[i]);
+    alpha_[i] += dtheta[i];
+    nu_[i] += dv[i];
+    prev_dtheta_[i] = dtheta[i];
+    prev_dv_[i] = dv[i];
+  }
+  dt_s_ += dt_s;
+  num_samples_++;
+}
+void Mpu9250Integrator::Cross(const float a[3], const float b[3], float c[3]) {
+  c[0] = a[1] * b[2] - a[2] * b[1];
+  c[1] = a[2] * b[0] - a[0] * b[2];
+  c[2] = a[0] * b[1] - a[1] * b[0];
+}
@@ -0,0 +1,65 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_INTEGRATOR_H_
+#define INCLUDE_MPU9250_MPU9250_INTEGRATOR_H_
+
+#include "Arduino.h"
+#include "mpu9250.h"
+
+/*
+* Integrates every gyro and accel sample into delta angles and delta
+* velocities over the consumer interval, using Savage's recursive coning
+* and sculling corrections. Increments are formed from the sample and the
+* time since the previous sample, so FIFO frames and data ready reads can
+* both be used.
+*/
+class Mpu9250Integrator {
+ public:
+  void Update(const Mpu9250 &imu);
+  void Update(const Mpu9250::Sample &sample);
+  void Reset();
+  void delta_angle_rad(float dtheta_rad[3]) const;
+  void delta_velocity_mps(float dv_mps[3]) const;
+  inline float dt_s() const {return dt_s_;}
+  inline uint32_t num_samples() const {return num_samples_;}
+
+ private:
+  void Integrate(const uint32_t time_us, const float gyro_radps[3],
+                 const float accel_mps2[3]);
+  static void Cross(const float a[3], const float b[3], float c[3]);
+  bool init_ = false;
+  uint32_t prev_time_us_ = 0;
+  /* Previous sample increments, carried across Reset */
+  float prev_dtheta_[3] = {}, prev_dv_[3] = {};
+  /* Accumulated angle and velocity increments */
+  float alpha_[3] = {}, nu_[3] = {};
+  /* Accumulated coning and sculling corrections */
+  float beta_[3] = {}, scul_[3] = {};
+  float dt_s_ = 0;
+  uint32_t num_samples_ = 0;
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_INTEGRATOR_H_
@@ -0,0 +1,164 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include <string.h>
+#include "mpu9250.h"
+#include "mpu9250_log.h"
+
+constexpr uint8_t Mpu9250Log::SYNC;
+constexpr uint8_t Mpu9250Log::CONFIG_SYNC;
+constexpr uint8_t Mpu9250Log::VERSION;
+constexpr size_t Mpu9250Log::RECORD_SIZE;
+constexpr size_t Mpu9250Log::CONFIG_RECORD_SIZE;
+constexpr uint8_t Mpu9250Log::MAX_CONFIG_ID;
+
+/*
+* Sample record layout:
+* [0] sync, [1] header: accel range bits 0-1, gyro range bits 2-3, new
+* magnetometer data bit 4, config id bits 5-7, [2-5] time_us, [6-11] accel
+* counts, [12-17] gyro counts, [18-19] temperature counts, [20-25] mag
+* counts, only present with new magnetometer data
+*
+* Config record layout:
+* [0] config sync, [1] version, [2] config id, [3-14] mag scale factors,
+* uT / count, IEEE 754 single precision
+*/
+size_t Mpu9250Log::Encode(const Mpu9250 &imu, uint8_t * const buf,
+                          const size_t len, const uint8_t config_id) {
+  size_t size = (imu.new_mag_data()) ? RECORD_SIZE : SAMPLE_SIZE_;
+  if ((!buf) || (len < size) || (config_id > MAX_CONFIG_ID)) {
+    return 0;
+  }
+  buf[0] = SYNC;
+  buf[1] = (imu.accel_range() >> 3) | ((imu.gyro_range() >> 3) << 2) |
+           (imu.new_mag_data() ? NEW_MAG_DATA_ : 0) |
+           (config_id << CONFIG_ID_SHIFT_);
+  PutUint32(imu.time_us(), buf + 2);
+  PutInt16(imu.accel_x_cnts(), buf + 6);
+  PutInt16(imu.accel_y_cnts(), buf + 8);
+  PutInt16(imu.accel_z_cnts(), buf + 10);
+  PutInt16(imu.gyro_x_cnts(), buf + 12);
+  PutInt16(imu.gyro_y_cnts(), buf + 14);
+  PutInt16(imu.gyro_z_cnts(), buf + 16);
+  PutInt16(imu.die_temperature_cnts(), buf + 18);
+  if (imu.new_mag_data()) {
+    PutInt16(imu.mag_x_cnts(), buf + 20);
+    PutInt16(imu.mag_y_cnts(), buf + 22);
+    PutInt16(imu.mag_z_cnts(), buf + 24);
+  }
+  return size;
+}
+size_t Mpu9250Log::Decode(const uint8_t * const buf, const size_t len,
+                          Record * const rec) {
+  if ((!buf) || (!rec) || (len < SAMPLE_SIZE_) || (buf[0] != SYNC)) {
+    return 0;
+  }
+  size_t size = (buf[1] & NEW_MAG_DATA_) ? RECORD_SIZE : SAMPLE_SIZE_;
+  if (len < size) {
+    return 0;
+  }
+  rec->accel_range = static_cast<Mpu9250::AccelRange>((buf[1] & 0x03) << 3);
+  rec->gyro_range = static_cast<Mpu9250::GyroRange>(((buf[1] >> 2) & 0x03)
+                                                    << 3);
+  rec->new_mag_data = buf[1] & NEW_MAG_DATA_;
+  rec->config_id = buf[1] >> CONFIG_ID_SHIFT_;
+  rec->time_us = GetUint32(buf + 2);
+  for (uint8_t i = 0; i < 3; i++) {
+    rec->accel_cnts[i] = GetInt16(buf + 6 + 2 * i);
+    rec->gyro_cnts[i] = GetInt16(buf + 12 + 2 * i);
+    rec->mag_cnts[i] = (rec->new_mag_data) ? GetInt16(buf + 20 + 2 * i) : 0;
+  }
+  rec->die_temperature_cnts = GetInt16(buf + 18);
+  return size;
+}
+size_t Mpu9250Log::EncodeConfig(const Mpu9250 &imu, const uint8_t id,
+                                uint8_t * const buf, const size_t len) {
+  if ((!buf) || (len < CONFIG_RECORD_SIZE) || (id > MAX_CONFIG_ID)) {
+    return 0;
+  }
+  buf[0] = CONFIG_SYNC;
+  buf[1] = VERSION;
+  buf[2] = id;
+  for (uint8_t i = 0; i < 3; i++) {
+    uint32_t bits;
+    memcpy(&bits, &imu.mag_scale_[i], sizeof(bits));
+    PutUint32(bits, buf + 3 + 4 * i);
+  }
+  return CONFIG_RECORD_SIZE;
+}
+size_t Mpu9250Log::DecodeConfig(const uint8_t * const buf, const size_t len,
+                                Config * const config) {
+  if ((!buf) || (!config) || (len < CONFIG_RECORD_SIZE)) {
+    return 0;
+  }
+  if ((buf[0] != CONFIG_SYNC) || (buf[1] != VERSION) ||
+      (buf[2] > MAX_CONFIG_ID)) {
+    return 0;
+  }
+  config->id = buf[2];
+  for (uint8_t i = 0; i < 3; i++) {
+    uint32_t bits = GetUint32(buf + 3 + 4 * i);
+    memcpy(&config->mag_scale[i], &bits, sizeof(bits));
+  }
+  return CONFIG_RECORD_SIZE;
+}
+void Mpu9250Log::Convert(const Record &rec, const Config &config,
+                         Mpu9250::Sample * const sample) {
+  if (!sample) {
+    return;
+  }
+  float accel_scale = Mpu9250::AccelScale(rec.accel_range) * Mpu9250::G_MPS2_;
+  float gyro_scale = Mpu9250::GyroScale(rec.gyro_range) * Mpu9250::DEG2RAD_;
+  sample->time_us = rec.time_us;
+  for (uint8_t i = 0; i < 3; i++) {
+    sample->accel_mps2[i] = static_cast<float>(rec.accel_cnts[i]) *
+                            accel_scale;
+    sample->gyro_radps[i] = static_cast<float>(rec.gyro_cnts[i]) * gyro_scale;
+    sample->mag_ut[i] = static_cast<float>(rec.mag_cnts[i]) *
+                        config.mag_scale[i];
+  }
+  sample->die_temperature_c = static_cast<float>(rec.die_temperature_cnts) *
+                              Mpu9250::TEMP_SCALE_ + Mpu9250::TEMP_OFFSET_;
+}
+void Mpu9250Log::PutInt16(const int16_t val, uint8_t * const buf) {
+  buf[0] = static_cast<uint16_t>(val) & 0xFF;
+  buf[1] = static_cast<uint16_t>(val) >> 8;
+}
+int16_t Mpu9250Log::GetInt16(const uint8_t * const buf) {
+  return static_cast<int16_t>(static_cast<uint16_t>(buf[1]) << 8 | buf[0]);
+}
+void Mpu9250Log::PutUint32(const uint32_t val, uint8_t * const buf) {
+  buf[0] = val & 0xFF;
+  buf[1] = (val >> 8) & 0xFF;
+  buf[2] = (val >> 16) & 0xFF;
+  buf[3] = (val >> 24) & 0xFF;
+}
+uint32_t Mpu9250Log::GetUint32(const uint8_t * const buf) {
+  return static_cast<uint32_t>(buf[0]) |
+         static_cast<uint32_t>(buf[1]) << 8 |
+         static_cast<uint32_t>(buf[2]) << 16 |
+         static_cast<uint32_t>(buf[3]) << 24;
+}
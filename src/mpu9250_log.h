@@ -0,0 +1,85 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_LOG_H_
+#define INCLUDE_MPU9250_MPU9250_LOG_H_
+
+#include "Arduino.h"
+#include "mpu9250.h"
+
+/*
+* Compact, versioned binary records for logging. Sample records hold the raw
+* counts along with the ranges and a config id, config records hold the
+* format version and the magnetometer scale factors for that id, so a log
+* can be converted to engineering units on its own. Records are encoded
+* little endian with a sync byte so streams can be resynchronized, and the
+* magnetometer counts are only stored when they are new.
+*/
+class Mpu9250Log {
+ public:
+  static constexpr uint8_t SYNC = 0xB5;
+  static constexpr uint8_t CONFIG_SYNC = 0xB6;
+  static constexpr uint8_t VERSION = 2;
+  /* Sample records are 20 bytes, or 26 with new magnetometer data */
+  static constexpr size_t RECORD_SIZE = 26;
+  static constexpr size_t CONFIG_RECORD_SIZE = 15;
+  static constexpr uint8_t MAX_CONFIG_ID = 7;
+  struct Record {
+    uint32_t time_us;
+    uint8_t config_id;
+    Mpu9250::AccelRange accel_range;
+    Mpu9250::GyroRange gyro_range;
+    bool new_mag_data;
+    int16_t accel_cnts[3];
+    int16_t gyro_cnts[3];
+    int16_t mag_cnts[3];
+    int16_t die_temperature_cnts;
+  };
+  struct Config {
+    uint8_t id;
+    float mag_scale[3];
+  };
+  static size_t Encode(const Mpu9250 &imu, uint8_t * const buf,
+                       const size_t len, const uint8_t config_id = 0);
+  static size_t Decode(const uint8_t * const buf, const size_t len,
+                       Record * const rec);
+  static size_t EncodeConfig(const Mpu9250 &imu, const uint8_t id,
+                             uint8_t * const buf, const size_t len);
+  static size_t DecodeConfig(const uint8_t * const buf, const size_t len,
+                             Config * const config);
+  static void Convert(const Record &rec, const Config &config,
+                      Mpu9250::Sample * const sample);
+
+ private:
+  static constexpr uint8_t NEW_MAG_DATA_ = 0x10;
+  static constexpr uint8_t CONFIG_ID_SHIFT_ = 5;
+  static constexpr size_t SAMPLE_SIZE_ = 20;
+  static void PutInt16(const int16_t val, uint8_t * const buf);
+  static int16_t GetInt16(const uint8_t * const buf);
+  static void PutUint32(const uint32_t val, uint8_t * const buf);
+  static uint32_t GetUint32(const uint8_t * const buf);
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_LOG_H_
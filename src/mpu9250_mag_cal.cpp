@@ -0,0 +1,242 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "mpu9250.h"
+#include "mpu9250_mag_cal.h"
+#include <math.h>
+
+bool Mpu9250MagCal::Update(const Mpu9250 &imu) {
+  /* Repeated samples would weight the fit towards slow motion */
+  if (!imu.new_mag_data_) {
+    return false;
+  }
+  /* Fit the data before the current calibration is applied */
+  float mag_ut[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    mag_ut[i] = static_cast<float>(imu.mag_cnts_[i]) * imu.mag_scale_[i];
+  }
+  Update(mag_ut);
+  return true;
+}
+void Mpu9250MagCal::Update(const float mag_ut[3]) {
+  const double x = mag_ut[0], y = mag_ut[1], z = mag_ut[2];
+  const double d[NUM_PARAMS_] = {
+    x * x, y * y, z * z,
+    2.0 * x * y, 2.0 * x * z, 2.0 * y * z,
+    2.0 * x, 2.0 * y, 2.0 * z
+  };
+  uint8_t k = 0;
+  for (uint8_t i = 0; i < NUM_PARAMS_; i++) {
+    dt1_[i] += d[i];
+    for (uint8_t j = i; j < NUM_PARAMS_; j++) {
+      dtd_[k++] += d[i] * d[j];
+    }
+  }
+  num_samples_++;
+}
+void Mpu9250MagCal::Reset() {
+  for (uint8_t k = 0; k < NUM_TERMS_; k++) {
+    dtd_[k] = 0;
+  }
+  for (uint8_t i = 0; i < NUM_PARAMS_; i++) {
+    dt1_[i] = 0;
+  }
+  num_samples_ = 0;
+}
+bool Mpu9250MagCal::Compute(float bias_ut[3], float scale[3][3]) const {
+  if (num_samples_ < MIN_SAMPLES) {
+    return false;
+  }
+  /* Solve D'D p = D'1 for the quadric x'Ax + 2g'x = 1 */
+  double a[NUM_PARAMS_][NUM_PARAMS_];
+  double p[NUM_PARAMS_];
+  uint8_t k = 0;
+  for (uint8_t i = 0; i < NUM_PARAMS_; i++) {
+    p[i] = dt1_[i];
+    for (uint8_t j = i; j < NUM_PARAMS_; j++) {
+      a[i][j] = dtd_[k];
+      a[j][i] = dtd_[k];
+      k++;
+    }
+  }
+  if (!Solve(a, p)) {
+    return false;
+  }
+  double q[3][3] = {
+    {p[0], p[3], p[4]},
+    {p[3], p[1], p[5]},
+    {p[4], p[5], p[2]}
+  };
+  const double g[3] = {p[6], p[7], p[8]};
+  /* A = V diag(lambda) V' */
+  double v[3][3];
+  Eigen(q, v);
+  const double lambda[3] = {q[0][0], q[1][1], q[2][2]};
+  for (uint8_t i = 0; i < 3; i++) {
+    if (lambda[i] == 0.0) {
+      return false;
+    }
+  }
+  /* Center c = -A^-1 g, and (x - c)'A(x - c) = 1 + c'Ac */
+  double vtg[3], vtc[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    vtg[i] = v[0][i] * g[0] + v[1][i] * g[1] + v[2][i] * g[2];
+    vtc[i] = -vtg[i] / lambda[i];
+  }
+  double r = 1.0;
+  for (uint8_t i = 0; i < 3; i++) {
+    r += lambda[i] * vtc[i] * vtc[i];
+  }
+  if (r == 0.0) {
+    return false;
+  }
+  /* The normalized ellipsoid matrix must be positive definite */
+  double lm[3];
+  double lm_min = 0, lm_max = 0;
+  for (uint8_t i = 0; i < 3; i++) {
+    lm[i] = lambda[i] / r;
+    if (lm[i] <= 0.0) {
+      return false;
+    }
+    if ((i == 0) || (lm[i] < lm_min)) {
+      lm_min = lm[i];
+    }
+    if ((i == 0) || (lm[i] > lm_max)) {
+      lm_max = lm[i];
+    }
+  }
+  /* Axis lengths go as 1 / sqrt(lambda), reject poorly covered fits */
+  if (lm_max > lm_min * MAX_AXIS_RATIO * MAX_AXIS_RATIO) {
+    return false;
+  }
+  /* Scale by the geometric mean radius so the field strength is kept */
+  const double gain = pow(lm[0] * lm[1] * lm[2], -1.0 / 6.0);
+  double w[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    w[i] = sqrt(lm[i]) * gain;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    bias_ut[i] = static_cast<float>(v[i][0] * vtc[0] + v[i][1] * vtc[1] +
+                                    v[i][2] * vtc[2]);
+    for (uint8_t j = 0; j < 3; j++) {
+      scale[i][j] = static_cast<float>(v[i][0] * w[0] * v[j][0] +
+                                       v[i][1] * w[1] * v[j][1] +
+                                       v[i][2] * w[2] * v[j][2]);
+    }
+  }
+  return true;
+}
+bool Mpu9250MagCal::Solve(double a[NUM_PARAMS_][NUM_PARAMS_],
+                          double b[NUM_PARAMS_]) {
+  /* Gaussian elimination with partial pivoting, solution left in b */
+  double max_diag = 0;
+  for (uint8_t i = 0; i < NUM_PARAMS_; i++) {
+    if (fabs(a[i][i]) > max_diag) {
+      max_diag = fabs(a[i][i]);
+    }
+  }
+  const double tol = max_diag * 1e-15;
+  for (uint8_t c = 0; c < NUM_PARAMS_; c++) {
+    uint8_t piv = c;
+    for (uint8_t r = c + 1; r < NUM_PARAMS_; r++) {
+      if (fabs(a[r][c]) > fabs(a[piv][c])) {
+        piv = r;
+      }
+    }
+    if (fabs(a[piv][c]) <= tol) {
+      return false;
+    }
+    if (piv != c) {
+      for (uint8_t j = c; j < NUM_PARAMS_; j++) {
+        double t = a[c][j];
+        a[c][j] = a[piv][j];
+        a[piv][j] = t;
+      }
+      double t = b[c];
+      b[c] = b[piv];
+      b[piv] = t;
+    }
+    for (uint8_t r = c + 1; r < NUM_PARAMS_; r++) {
+      double f = a[r][c] / a[c][c];
+      for (uint8_t j = c; j < NUM_PARAMS_; j++) {
+        a[r][j] -= f * a[c][j];
+      }
+      b[r] -= f * b[c];
+    }
+  }
+  for (int8_t r = NUM_PARAMS_ - 1; r >= 0; r--) {
+    double sum = b[r];
+    for (uint8_t j = r + 1; j < NUM_PARAMS_; j++) {
+      sum -= a[r][j] * b[j];
+    }
+    b[r] = sum / a[r][r];
+  }
+  return true;
+}
+void Mpu9250MagCal::Eigen(double a[3][3], double v[3][3]) {
+  /* Cyclic Jacobi, eigenvalues left on the diagonal of a, vectors in v */
+  for (uint8_t i = 0; i < 3; i++) {
+    for (uint8_t j = 0; j < 3; j++) {
+      v[i][j] = (i == j) ? 1.0 : 0.0;
+    }
+  }
+  for (uint8_t sweep = 0; sweep < 16; sweep++) {
+    double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+    if (off == 0.0) {
+      return;
+    }
+    for (uint8_t p = 0; p < 2; p++) {
+      for (uint8_t q = p + 1; q < 3; q++) {
+        if (a[p][q] == 0.0) {
+          continue;
+        }
+        double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+        double t = ((theta >= 0.0) ? 1.0 : -1.0) /
+                   (fabs(theta) + sqrt(theta * theta + 1.0));
+        double c = 1.0 / sqrt(t * t + 1.0);
+        double s = t * c;
+        for (uint8_t k = 0; k < 3; k++) {
+          double akp = a[k][p];
+          double akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (uint8_t k = 0; k < 3; k++) {
+          double apk = a[p][k];
+          double aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (uint8_t k = 0; k < 3; k++) {
+          double vkp = v[k][p];
+          double vkq = v[k][q];
+          v[k][p] = c * vkp - s * vkq;
+          v[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+}
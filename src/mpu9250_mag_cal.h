@@ -0,0 +1,64 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_MAG_CAL_H_
+#define INCLUDE_MPU9250_MPU9250_MAG_CAL_H_
+
+#include "Arduino.h"
+#include "mpu9250.h"
+
+/*
+* Incremental ellipsoid fit of magnetometer data for hard and soft iron
+* calibration. Each sample adds to the normal equations of a least squares
+* fit of the general quadric, so memory use is constant. The sums are kept
+* as double, since the normal equations hold the fourth power of the field.
+* That is 64 bit only where the target's double is: hardware on FPUs with
+* double support (Cortex-M7), software emulated on single precision FPUs
+* (Cortex-M4F, ESP32), and on 8 bit AVR double is 32 bit, so the fit is done
+* in single precision and poorly conditioned data is more likely rejected.
+*/
+class Mpu9250MagCal {
+ public:
+  static constexpr uint16_t MIN_SAMPLES = 200;
+  static constexpr float MAX_AXIS_RATIO = 3.0f;
+  bool Update(const Mpu9250 &imu);
+  void Update(const float mag_ut[3]);
+  void Reset();
+  inline uint32_t num_samples() const {return num_samples_;}
+  bool Compute(float bias_ut[3], float scale[3][3]) const;
+
+ private:
+  static constexpr uint8_t NUM_PARAMS_ = 9;
+  static constexpr uint8_t NUM_TERMS_ = NUM_PARAMS_ * (NUM_PARAMS_ + 1) / 2;
+  static bool Solve(double a[NUM_PARAMS_][NUM_PARAMS_],
+                    double b[NUM_PARAMS_]);
+  static void Eigen(double a[3][3], double v[3][3]);
+  /* Upper triangle of D'D and D'1, D = [xx yy zz 2xy 2xz 2yz 2x 2y 2z] */
+  double dtd_[NUM_TERMS_] = {};
+  double dt1_[NUM_PARAMS_] = {};
+  uint32_t num_samples_ = 0;
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_MAG_CAL_H_
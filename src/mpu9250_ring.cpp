@@ -0,0 +1,55 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "mpu9250.h"
+#include "mpu9250_ring.h"
+
+bool Mpu9250Ring::Push(const Mpu9250::Sample &sample) {
+  uint8_t head = head_;
+  if (static_cast<uint8_t>(head - tail_) >= capacity_) {
+    dropped_ = dropped_ + 1;
+    return false;
+  }
+  buf_[head & (capacity_ - 1)] = sample;
+  /* Publish the sample only after it is completely written */
+  __asm__ __volatile__("" ::: "memory");
+  head_ = head + 1;
+  return true;
+}
+bool Mpu9250Ring::Pop(Mpu9250::Sample * const sample) {
+  if (!sample) {
+    return false;
+  }
+  uint8_t tail = tail_;
+  if (head_ == tail) {
+    return false;
+  }
+  *sample = buf_[tail & (capacity_ - 1)];
+  /* Release the slot only after it is completely read */
+  __asm__ __volatile__("" ::: "memory");
+  tail_ = tail + 1;
+  return true;
+}
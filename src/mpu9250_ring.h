@@ -0,0 +1,70 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_RING_H_
+#define INCLUDE_MPU9250_MPU9250_RING_H_
+
+#include "Arduino.h"
+#include "mpu9250.h"
+
+/*
+* Single producer, single consumer ring of samples. The producer (the
+* Mpu9250 object, possibly in an ISR) only writes the head and the consumer
+* only writes the tail, so no interrupts need to be disabled. Indices are
+* 8 bit so that they are read and written atomically on all platforms.
+*/
+class Mpu9250Ring {
+ public:
+  bool Push(const Mpu9250::Sample &sample);
+  bool Pop(Mpu9250::Sample * const sample);
+  inline uint8_t size() const {return static_cast<uint8_t>(head_ - tail_);}
+  inline uint8_t capacity() const {return capacity_;}
+  inline bool empty() const {return head_ == tail_;}
+  inline uint32_t dropped() const {return dropped_;}
+
+ protected:
+  Mpu9250Ring(Mpu9250::Sample * const buf, const uint8_t capacity) :
+    buf_(buf), capacity_(capacity) {}
+
+ private:
+  Mpu9250::Sample * const buf_;
+  const uint8_t capacity_;
+  volatile uint8_t head_ = 0;
+  volatile uint8_t tail_ = 0;
+  volatile uint32_t dropped_ = 0;
+};
+
+template<uint8_t N>
+class Mpu9250RingBuffer : public Mpu9250Ring {
+ public:
+  static_assert((N > 0) && (N <= 128) && ((N & (N - 1)) == 0),
+                "Ring capacity must be a power of 2, up to 128");
+  Mpu9250RingBuffer() : Mpu9250Ring(storage_, N) {}
+
+ private:
+  Mpu9250::Sample storage_[N];
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_RING_H_
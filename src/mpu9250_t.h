@@ -0,0 +1,307 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2021 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef INCLUDE_MPU9250_MPU9250_T_H_
+#define INCLUDE_MPU9250_MPU9250_T_H_
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "SPI.h"
+#include "mpu9250.h"
+#include "mpu9250_core.h"
+
+/* SPI bus for Mpu9250T */
+class Mpu9250SpiBus {
+ public:
+  Mpu9250SpiBus(SPIClass *bus, uint8_t cs, uint32_t reg_clock = 1000000,
+                uint32_t data_clock = 20000000) : spi_(bus), cs_(cs),
+    reg_settings_(reg_clock, MSBFIRST, SPI_MODE3),
+    data_settings_(data_clock, MSBFIRST, SPI_MODE3) {}
+  void Begin() {
+    pinMode(cs_, OUTPUT);
+    CsHigh();
+    spi_->begin();
+  }
+  bool WriteRegister(uint8_t reg, uint8_t data) {
+    spi_->beginTransaction(reg_settings_);
+    CsLow();
+    spi_->transfer(reg);
+    spi_->transfer(data);
+    CsHigh();
+    spi_->endTransaction();
+    return true;
+  }
+  bool ReadRegisters(uint8_t reg, uint8_t count, uint8_t *data,
+                     const bool fast) {
+    spi_->beginTransaction(fast ? data_settings_ : reg_settings_);
+    CsLow();
+    spi_->transfer(reg | SPI_READ_);
+    spi_->transfer(data, count);
+    CsHigh();
+    spi_->endTransaction();
+    return true;
+  }
+
+ private:
+  SPIClass *spi_;
+  uint8_t cs_;
+  SPISettings reg_settings_, data_settings_;
+  static constexpr uint8_t SPI_READ_ = 0x80;
+  inline void CsLow() {
+    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+        defined(__IMXRT1052__)
+    digitalWriteFast(cs_, LOW);
+    #else
+    digitalWrite(cs_, LOW);
+    #endif
+    #if defined(__IMXRT1062__)
+      delayNanoseconds(200);
+    #endif
+  }
+  inline void CsHigh() {
+    #if defined(__MK20DX128__) || defined(__MK20DX256__) || \
+        defined(__MK64FX512__) || defined(__MK66FX1M0__) || \
+        defined(__MKL26Z64__)  || defined(__IMXRT1062__) || \
+        defined(__IMXRT1052__)
+    digitalWriteFast(cs_, HIGH);
+    #else
+    digitalWrite(cs_, HIGH);
+    #endif
+    #if defined(__IMXRT1062__)
+      delayNanoseconds(200);
+    #endif
+  }
+};
+
+/* I2C bus for Mpu9250T */
+class Mpu9250I2cBus {
+ public:
+  Mpu9250I2cBus(TwoWire *bus, uint8_t addr, uint32_t clock = 400000) :
+    i2c_(bus), addr_(addr), clock_(clock) {}
+  void Begin() {
+    i2c_->begin();
+    i2c_->setClock(clock_);
+  }
+  bool WriteRegister(uint8_t reg, uint8_t data) {
+    i2c_->beginTransmission(addr_);
+    i2c_->write(reg);
+    i2c_->write(data);
+    return (i2c_->endTransmission() == 0);
+  }
+  bool ReadRegisters(uint8_t reg, uint8_t count, uint8_t *data,
+                     const bool fast) {
+    (void) fast;
+    i2c_->beginTransmission(addr_);
+    i2c_->write(reg);
+    if (i2c_->endTransmission(false) != 0) {
+      return false;
+    }
+    if (i2c_->requestFrom(addr_, count) != count) {
+      return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+      data[i] = i2c_->read();
+    }
+    return true;
+  }
+
+ private:
+  TwoWire *i2c_;
+  uint8_t addr_;
+  uint32_t clock_;
+};
+
+/*
+* Mpu9250 with the bus and full scale ranges fixed at compile time. There is
+* no runtime interface branching, the scale factors are constant, and only
+* the code for the selected bus is linked.
+*/
+template<typename Bus,
+         Mpu9250::AccelRange ACCEL_RANGE = Mpu9250::ACCEL_RANGE_16G,
+         Mpu9250::GyroRange GYRO_RANGE = Mpu9250::GYRO_RANGE_2000DPS>
+class Mpu9250T {
+ public:
+  explicit Mpu9250T(const Bus &bus) : bus_(bus) {}
+  bool Begin() {
+    bus_.Begin();
+    /* Reset the MPU-9250 and AK8963 and check their WHO AM I bytes */
+    if (!Mpu9250Core<Mpu9250T>::Reset(this, M::I2C_MST_CLK_)) {
+      return false;
+    }
+    /* Get the magnetometer calibration */
+    if (!Mpu9250Core<Mpu9250T>::ReadMagScale(this, mag_scale_)) {
+      return false;
+    }
+    /* Set AK8963 to 16 bit resolution, 100 Hz update rate */
+    if (!Mpu9250Core<Mpu9250T>::ConfigAk8963Mode(this, M::AK8963_CNT_MEAS2_)) {
+      return false;
+    }
+    /* Set the compile time ranges, the reset left the SRD at 0 */
+    if (!WriteRegister(M::ACCEL_CONFIG_, ACCEL_RANGE)) {
+      return false;
+    }
+    if (!WriteRegister(M::GYRO_CONFIG_, GYRO_RANGE)) {
+      return false;
+    }
+    /* Set the DLPF to 20HZ by default */
+    return ConfigDlpf(Mpu9250::DLPF_BANDWIDTH_20HZ);
+  }
+  bool ConfigSrd(const uint8_t srd) {
+    return Mpu9250Core<Mpu9250T>::ConfigSrd(this, srd);
+  }
+  inline uint8_t srd() const {return srd_;}
+  bool ConfigDlpf(const Mpu9250::DlpfBandwidth dlpf) {
+    if ((dlpf < Mpu9250::DLPF_BANDWIDTH_184HZ) ||
+        (dlpf > Mpu9250::DLPF_BANDWIDTH_5HZ)) {
+      return false;
+    }
+    if (!WriteRegister(M::ACCEL_CONFIG2_, dlpf)) {
+      return false;
+    }
+    if (!WriteRegister(M::CONFIG_, dlpf)) {
+      return false;
+    }
+    dlpf_bandwidth_ = dlpf;
+    return true;
+  }
+  inline Mpu9250::DlpfBandwidth dlpf() const {return dlpf_bandwidth_;}
+  static constexpr Mpu9250::AccelRange accel_range() {return ACCEL_RANGE;}
+  static constexpr Mpu9250::GyroRange gyro_range() {return GYRO_RANGE;}
+  inline void ConfigWriteVerify(const Mpu9250::WriteVerify verify) {
+    write_verify_ = verify;
+  }
+  inline Mpu9250::WriteVerify write_verify() const {return write_verify_;}
+  bool ReadRaw() {
+    uint8_t data_buff[M::DATA_LEN_];
+    if (!bus_.ReadRegisters(M::INT_STATUS_, sizeof(data_buff), data_buff,
+                            true)) {
+      return false;
+    }
+    /* Check if data is ready */
+    if (!(data_buff[0] & M::RAW_DATA_RDY_INT_)) {
+      return false;
+    }
+    /* Unpack the buffer and rotate the accel / gyro axis */
+    accel_cnts_[1] = static_cast<int16_t>(data_buff[1])  << 8 | data_buff[2];
+    accel_cnts_[0] = static_cast<int16_t>(data_buff[3])  << 8 | data_buff[4];
+    accel_cnts_[2] = M::Negate(static_cast<int16_t>(data_buff[5]) << 8 |
+                               data_buff[6]);
+    temp_cnts_ =     static_cast<int16_t>(data_buff[7])  << 8 | data_buff[8];
+    gyro_cnts_[1] =  static_cast<int16_t>(data_buff[9])  << 8 | data_buff[10];
+    gyro_cnts_[0] =  static_cast<int16_t>(data_buff[11]) << 8 | data_buff[12];
+    gyro_cnts_[2] =  M::Negate(static_cast<int16_t>(data_buff[13]) << 8 |
+                               data_buff[14]);
+    mag_cnts_[0] = static_cast<int16_t>(data_buff[17]) << 8 | data_buff[16];
+    mag_cnts_[1] = static_cast<int16_t>(data_buff[19]) << 8 | data_buff[18];
+    mag_cnts_[2] = static_cast<int16_t>(data_buff[21]) << 8 | data_buff[20];
+    return true;
+  }
+  void Convert() {
+    for (uint8_t i = 0; i < 3; i++) {
+      accel_mps2_[i] = static_cast<float>(accel_cnts_[i]) * ACCEL_SCALE_;
+      gyro_radps_[i] = static_cast<float>(gyro_cnts_[i]) * GYRO_SCALE_;
+      mag_ut_[i] = static_cast<float>(mag_cnts_[i]) * mag_scale_[i];
+    }
+    die_temperature_c_ = static_cast<float>(temp_cnts_) * M::TEMP_SCALE_ +
+                         M::TEMP_OFFSET_;
+  }
+  bool Read() {
+    if (!ReadRaw()) {
+      return false;
+    }
+    Convert();
+    return true;
+  }
+  inline float accel_x_mps2() const {return accel_mps2_[0];}
+  inline float accel_y_mps2() const {return accel_mps2_[1];}
+  inline float accel_z_mps2() const {return accel_mps2_[2];}
+  inline float gyro_x_radps() const {return gyro_radps_[0];}
+  inline float gyro_y_radps() const {return gyro_radps_[1];}
+  inline float gyro_z_radps() const {return gyro_radps_[2];}
+  inline float mag_x_ut() const {return mag_ut_[0];}
+  inline float mag_y_ut() const {return mag_ut_[1];}
+  inline float mag_z_ut() const {return mag_ut_[2];}
+  inline float die_temperature_c() const {return die_temperature_c_;}
+  inline int16_t accel_x_cnts() const {return accel_cnts_[0];}
+  inline int16_t accel_y_cnts() const {return accel_cnts_[1];}
+  inline int16_t accel_z_cnts() const {return accel_cnts_[2];}
+  inline int16_t gyro_x_cnts() const {return gyro_cnts_[0];}
+  inline int16_t gyro_y_cnts() const {return gyro_cnts_[1];}
+  inline int16_t gyro_z_cnts() const {return gyro_cnts_[2];}
+  inline int16_t mag_x_cnts() const {return mag_cnts_[0];}
+  inline int16_t mag_y_cnts() const {return mag_cnts_[1];}
+  inline int16_t mag_z_cnts() const {return mag_cnts_[2];}
+  inline int16_t die_temperature_cnts() const {return temp_cnts_;}
+
+ private:
+  friend class Mpu9250Core<Mpu9250T>;
+  typedef Mpu9250 M;
+  Bus bus_;
+  /* Configuration */
+  Mpu9250::DlpfBandwidth dlpf_bandwidth_;
+  uint8_t srd_ = 0;
+  uint8_t smplrt_div_ = 0;
+  Mpu9250::WriteVerify write_verify_ = Mpu9250::WRITE_VERIFY;
+  /* Scale factors, the accel and gyro are fixed by the template ranges */
+  static constexpr float ACCEL_SCALE_ =
+    static_cast<float>(2 << (ACCEL_RANGE >> 3)) / 32767.5f * M::G_MPS2_;
+  static constexpr float GYRO_SCALE_ =
+    static_cast<float>(250 << (GYRO_RANGE >> 3)) / 32767.5f * M::DEG2RAD_;
+  float mag_scale_[3];
+  /* Data */
+  int16_t accel_cnts_[3] = {}, gyro_cnts_[3] = {}, temp_cnts_ = 0;
+  int16_t mag_cnts_[3] = {};
+  float accel_mps2_[3];
+  float gyro_radps_[3];
+  float mag_ut_[3];
+  float die_temperature_c_;
+  bool WriteRegister(uint8_t reg, uint8_t data) {
+    return WriteRegister(reg, data, write_verify_);
+  }
+  bool WriteRegister(uint8_t reg, uint8_t data,
+                     const Mpu9250::WriteVerify verify) {
+    uint8_t ret_val;
+    uint8_t attempts = (verify == M::WRITE_VERIFY_RETRY) ?
+                       M::WRITE_ATTEMPTS_ : 1;
+    for (uint8_t i = 0; i < attempts; i++) {
+      bool ack = bus_.WriteRegister(reg, data);
+      if (verify == M::WRITE_VERIFY_NONE) {
+        return ack;
+      }
+      if ((bus_.ReadRegisters(reg, sizeof(ret_val), &ret_val, false)) &&
+          (data == ret_val)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  bool ReadRegisters(uint8_t reg, uint8_t count, uint8_t *data) {
+    return bus_.ReadRegisters(reg, count, data, false);
+  }
+};
+
+#endif  // INCLUDE_MPU9250_MPU9250_T_H_